@@ -1,5 +1,6 @@
 #include "devices/timer.h"
 #include <debug.h>
+#include <heap.h>
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
@@ -17,14 +18,40 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
-/* Number of timer ticks since OS booted. */
+/* Number of timer ticks since OS booted.  Updated only by the
+   timer interrupt, and read through ticks_seq so that reading it
+   does not require turning interrupts off. */
 static int64_t ticks;
+static struct seqlock ticks_seq;
+
+/* PIT cycles per timer tick. */
+#define TICK_CYCLES ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Longest tickless idle period, in ticks.  The PIT's counter is
+   only 16 bits wide. */
+#define MAX_ONESHOT_TICKS (0xffff / TICK_CYCLES)
+
+/* See timer.h. */
+bool timer_tickless;
+
+/* While the PIT is counting down a one-shot instead of running
+   periodically, ONESHOT_TICKS is the number of tick boundaries
+   the one-shot spans, the last of which is where it runs out,
+   and ONESHOT_COUNT is the PIT count it was started with.
+   ONESHOT_TICKS is 0 in periodic mode. */
+static int oneshot_ticks;
+static unsigned oneshot_count;
+
+/* Number of timer interrupts avoided by tickless idle. */
+static int64_t skipped_ticks;
 
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
-struct list sleepers;
+/* Threads blocked in timer_sleep(), ordered by wake-up tick, so
+   that each timer interrupt only has to look at the earliest. */
+static struct heap sleepers;
 
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
@@ -33,6 +60,8 @@ static void real_time_sleep (int64_t num, int32_t denom);
 static void real_time_delay (int64_t num, int32_t denom);
 
 static void update_sleeping_threads(void);
+static void advance_ticks (int);
+static heap_less_func wakeup_tick_less;
 
 /* Sets up the timer to interrupt TIMER_FREQ times per second,
    and registers the corresponding interrupt. */
@@ -41,7 +70,8 @@ timer_init (void)
 {
   pit_configure_channel (0, 2, TIMER_FREQ);
   intr_register_ext (0x20, timer_interrupt, "8254 Timer");
-  list_init(&sleepers);
+  heap_init (&sleepers, wakeup_tick_less, NULL);
+  seqlock_init (&ticks_seq);
 }
 
 /* Calibrates loops_per_tick, used to implement brief delays. */
@@ -75,9 +105,15 @@ timer_calibrate (void)
 int64_t
 timer_ticks (void)
 {
-  enum intr_level old_level = intr_disable ();
-  int64_t t = ticks;
-  intr_set_level (old_level);
+  int64_t t;
+  unsigned seq;
+
+  do
+    {
+      seq = seqlock_read_begin (&ticks_seq);
+      t = ticks;
+    }
+  while (seqlock_read_retry (&ticks_seq, seq));
   return t;
 }
 
@@ -102,8 +138,8 @@ timer_sleep (int64_t ticks)
   old_level = intr_disable();
 
   struct thread *t = thread_current();
-  t->remaining_ticks = ticks;
-  list_push_back(&sleepers, &t->elem);
+  t->wakeup_tick = timer_ticks () + ticks;
+  heap_insert (&sleepers, &t->sleep_elem);
   thread_block();
 
   intr_set_level(old_level);
@@ -172,51 +208,160 @@ timer_ndelay (int64_t ns)
   real_time_delay (ns, 1000 * 1000 * 1000);
 }
 
+/* Called by the idle thread, with interrupts off, just before it
+   halts the CPU.  In tickless mode, replaces the periodic timer
+   interrupt by a one-shot that runs out at the tick when the
+   next sleeping thread is due, or as far ahead as the PIT can
+   count.  No time slice needs to end before then, because
+   nothing but the idle thread is runnable.  The ticks that pass
+   meanwhile are accounted for by timer_catch_up() or, if the
+   one-shot runs out, by the timer interrupt. */
+void
+timer_idle (void)
+{
+  unsigned first;
+  int n;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (!timer_tickless || oneshot_ticks > 0)
+    return;
+
+  n = MAX_ONESHOT_TICKS;
+  if (!heap_empty (&sleepers))
+    {
+      struct thread *t = heap_entry (heap_min (&sleepers), struct thread,
+                                     sleep_elem);
+      if (t->wakeup_tick - ticks < n)
+        n = t->wakeup_tick - ticks;
+    }
+  if (n <= 1)
+    return;
+
+  /* Keep the tick boundaries where they would have been: the
+     first one comes when the current period ends. */
+  first = pit_read_count (0);
+  if (first == 0 || first > TICK_CYCLES)
+    first = TICK_CYCLES;
+
+  oneshot_ticks = n;
+  oneshot_count = first + (n - 1) * TICK_CYCLES;
+  pit_start_oneshot (0, oneshot_count);
+}
+
+/* Called on every external interrupt other than the timer's, in
+   interrupt context.  If the interrupt ends a tickless idle
+   period early, runs the timer interrupt's work once for each
+   tick boundary that has passed, then counts out the rest of the
+   current tick so that the timer interrupt can go back to
+   periodic mode at a tick boundary. */
+void
+timer_catch_up (void)
+{
+  unsigned left;
+  int passed;
+
+  ASSERT (intr_context ());
+
+  if (oneshot_ticks == 0)
+    return;
+
+  left = pit_read_count (0);
+  if (left == 0 || left > oneshot_count)
+    {
+      /* The one-shot has run out and its interrupt is pending.
+         Leave the final tick to the timer interrupt. */
+      advance_ticks (oneshot_ticks - 1);
+      oneshot_ticks = 1;
+      oneshot_count = 0;
+      return;
+    }
+
+  passed = oneshot_ticks - DIV_ROUND_UP (left, TICK_CYCLES);
+  if (passed == 0 && oneshot_ticks == 1)
+    return;
+  advance_ticks (passed);
+
+  oneshot_ticks = 1;
+  oneshot_count = (left - 1) % TICK_CYCLES + 1;
+  pit_start_oneshot (0, oneshot_count);
+}
+
 /* Prints timer statistics. */
 void
 timer_print_stats (void)
 {
   printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+  if (timer_tickless)
+    printf ("Timer: %"PRId64" ticks skipped while idle\n", skipped_ticks);
 }
 
+/* Does the timer interrupt's work for N ticks that passed while
+   the PIT was counting down a one-shot. */
 static void
-update_sleeping_threads() {
-	
-  struct list_elem *e;
-
+advance_ticks (int n)
+{
   ASSERT (intr_get_level () == INTR_OFF);
 
+  skipped_ticks += n;
+  while (n-- > 0)
+    {
+      seqlock_write_begin (&ticks_seq);
+      ticks++;
+      seqlock_write_end (&ticks_seq);
+      update_sleeping_threads ();
+      thread_tick ();
+    }
+}
+
+/* Wakes up every sleeping thread whose wake-up tick has come.
+   Only the threads being woken are visited. */
+static void
+update_sleeping_threads() {
+  ASSERT (intr_get_level () == INTR_OFF);
   int should_yield = 0;
   int cur_thread_priority = thread_current ()->priority;
-  for (e = list_begin (&sleepers); e != list_end (&sleepers);)
+  while (!heap_empty (&sleepers))
     {
-      struct thread *t = list_entry (e, struct thread, elem);
-	  t->remaining_ticks--;
-	  if (t->remaining_ticks == 0) {
-	
-		if (!should_yield && t->priority > cur_thread_priority) {
-		  should_yield = 1;
-		}
-		
-		list_remove(e);
-
-		/* list_next must execute before thread_unblock 
-	       because thread_unblock will rewrite t.elem->next */
-		e = list_next(e);
-		thread_unblock(t);
-	  }
-	  else
-		e = list_next(e);
+      struct thread *t = heap_entry (heap_min (&sleepers), struct thread,
+                                     sleep_elem);
+      if (t->wakeup_tick > ticks)
+        break;
+
+      heap_pop_min (&sleepers);
+      if (t->priority > cur_thread_priority)
+        should_yield = 1;
+      thread_unblock (t);
     }
   if (should_yield) 
 	intr_yield_on_return ();
 }
 
+/* Returns true if thread A should wake up before thread B. */
+static bool
+wakeup_tick_less (const struct heap_elem *a, const struct heap_elem *b,
+                  void *aux UNUSED)
+{
+  return (heap_entry (a, struct thread, sleep_elem)->wakeup_tick
+          < heap_entry (b, struct thread, sleep_elem)->wakeup_tick);
+}
+
 /* Timer interrupt handler. */
 static void
 timer_interrupt (struct intr_frame *args UNUSED)
 {
+  if (oneshot_ticks > 0)
+    {
+      /* A one-shot ran out.  Account for the tick boundaries it
+         spanned before this one and resume periodic mode. */
+      advance_ticks (oneshot_ticks - 1);
+      oneshot_ticks = 0;
+      pit_configure_channel (0, 2, TIMER_FREQ);
+    }
+
+  seqlock_write_begin (&ticks_seq);
   ticks++;
+  seqlock_write_end (&ticks_seq);
   update_sleeping_threads();
   thread_tick ();
 }
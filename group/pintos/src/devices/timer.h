@@ -2,11 +2,19 @@
 #define DEVICES_TIMER_H
 
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
 #define TIMER_FREQ 100
 
+/* If false (default), the timer interrupts TIMER_FREQ times per
+   second all the time.
+   If true, the periodic interrupt is stopped while the CPU is
+   idle.  Controlled by kernel command-line option
+   "-o tickless". */
+extern bool timer_tickless;
+
 void timer_init (void);
 void timer_calibrate (void);
 
@@ -24,6 +32,10 @@ void timer_mdelay (int64_t milliseconds);
 void timer_udelay (int64_t microseconds);
 void timer_ndelay (int64_t nanoseconds);
 
+/* Tickless idle. */
+void timer_idle (void);
+void timer_catch_up (void);
+
 void timer_print_stats (void);
 
 #endif /* devices/timer.h */
@@ -3,6 +3,16 @@
 #include <string.h>
 #include <syscall.h>
 
+/* Most commands in one pipeline. */
+#define PIPELINE_MAX 8
+
+/* Where run_pipeline() keeps the shell's own standard input and
+   output while it hands descriptors 0 and 1 to its children. */
+#define SAVED_STDIN 10
+#define SAVED_STDOUT 11
+
+static void run_pipeline (char *command);
+static char *trim (char *);
 static void read_line (char line[], size_t);
 static bool backspace (char **pos, char line[]);
 
@@ -31,19 +41,102 @@ main (void)
           /* Empty command. */
         }
       else
-        {
-          pid_t pid = exec (command);
-          if (pid != PID_ERROR)
-            printf ("\"%s\": exit code %d\n", command, wait (pid));
-          else
-            printf ("exec failed\n");
-        }
+        run_pipeline (command);
     }
 
   printf ("Shell exiting.");
   return EXIT_SUCCESS;
 }
 
+/* Runs COMMAND, one or more commands separated by `|', each with
+   its standard output connected to the standard input of the
+   next through a pipe, and waits for them all to exit. */
+static void
+run_pipeline (char *command)
+{
+  char *stages[PIPELINE_MAX];
+  pid_t pids[PIPELINE_MAX];
+  size_t stage_cnt = 0;
+  size_t first;                 /* First command started. */
+  char *token, *save_ptr;
+  size_t i;
+
+  for (token = strtok_r (command, "|", &save_ptr); token != NULL;
+       token = strtok_r (NULL, "|", &save_ptr))
+    {
+      if (stage_cnt >= PIPELINE_MAX)
+        {
+          printf ("too many commands in pipeline\n");
+          return;
+        }
+      stages[stage_cnt++] = trim (token);
+    }
+
+  /* Start the commands from last to first.  Each one but the
+     first reads from a new pipe, whose write end then becomes
+     standard output for the command before it.  That way we have
+     closed a pipe's read end before we start the command that
+     writes into it, so once its reader exits, the writer's
+     writes fail instead of blocking forever.  Children inherit
+     only descriptors 0 through 2, so they never see the other
+     end of their own pipes. */
+  dup2 (STDIN_FILENO, SAVED_STDIN);
+  dup2 (STDOUT_FILENO, SAVED_STDOUT);
+  first = stage_cnt;
+  for (i = stage_cnt; i-- > 0; )
+    {
+      int fds[2];
+
+      if (i > 0)
+        {
+          if (!pipe (fds))
+            {
+              dup2 (SAVED_STDOUT, STDOUT_FILENO);
+              printf ("pipe failed\n");
+              break;
+            }
+          dup2 (fds[0], STDIN_FILENO);
+          close (fds[0]);
+        }
+      else
+        dup2 (SAVED_STDIN, STDIN_FILENO);
+
+      pids[i] = exec (stages[i]);
+      first = i;
+
+      if (i > 0)
+        {
+          dup2 (fds[1], STDOUT_FILENO);
+          close (fds[1]);
+        }
+    }
+  dup2 (SAVED_STDIN, STDIN_FILENO);
+  dup2 (SAVED_STDOUT, STDOUT_FILENO);
+  close (SAVED_STDIN);
+  close (SAVED_STDOUT);
+
+  for (i = first; i < stage_cnt; i++)
+    if (pids[i] != PID_ERROR)
+      printf ("\"%s\": exit code %d\n", stages[i], wait (pids[i]));
+    else
+      printf ("\"%s\": exec failed\n", stages[i]);
+}
+
+/* Strips leading and trailing spaces from S, in place, and
+   returns the result. */
+static char *
+trim (char *s)
+{
+  char *end;
+
+  while (*s == ' ')
+    s++;
+  end = s + strlen (s);
+  while (end > s && end[-1] == ' ')
+    *--end = '\0';
+  return s;
+}
+
 /* Reads a line of input from the user into LINE, which has room
    for SIZE bytes.  Handles backspace and Ctrl+U in the ways
    expected by Unix users.  On return, LINE will always be
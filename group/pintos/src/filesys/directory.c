@@ -5,8 +5,13 @@
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
-/* A directory. */
+/* A directory.
+
+   Lookups hold the directory inode's inode_dir_lock() for
+   reading, and adding and removing entries hold it for writing,
+   so that two files cannot be added under one name. */
 struct dir
   {
     struct inode *inode;                /* Backing store. */
@@ -124,10 +129,12 @@ dir_lookup (const struct dir *dir, const char *name,
   ASSERT (dir != NULL);
   ASSERT (name != NULL);
 
+  rwlock_acquire_read (inode_dir_lock (dir->inode));
   if (lookup (dir, name, &e, NULL))
     *inode = inode_open (e.inode_sector);
   else
     *inode = NULL;
+  rwlock_release_read (inode_dir_lock (dir->inode));
 
   return *inode != NULL;
 }
@@ -153,6 +160,7 @@ dir_add (struct dir *dir, const char *name, block_sector_t inode_sector)
     return false;
 
   /* Check that NAME is not in use. */
+  rwlock_acquire_write (inode_dir_lock (dir->inode));
   if (lookup (dir, name, NULL, NULL))
     goto done;
 
@@ -175,6 +183,7 @@ dir_add (struct dir *dir, const char *name, block_sector_t inode_sector)
   success = inode_write_at (dir->inode, &e, sizeof e, ofs) == sizeof e;
 
  done:
+  rwlock_release_write (inode_dir_lock (dir->inode));
   return success;
 }
 
@@ -193,6 +202,7 @@ dir_remove (struct dir *dir, const char *name)
   ASSERT (name != NULL);
 
   /* Find directory entry. */
+  rwlock_acquire_write (inode_dir_lock (dir->inode));
   if (!lookup (dir, name, &e, &ofs))
     goto done;
 
@@ -211,6 +221,7 @@ dir_remove (struct dir *dir, const char *name)
   success = true;
 
  done:
+  rwlock_release_write (inode_dir_lock (dir->inode));
   inode_close (inode);
   return success;
 }
@@ -222,15 +233,19 @@ bool
 dir_readdir (struct dir *dir, char name[NAME_MAX + 1])
 {
   struct dir_entry e;
+  bool found = false;
 
+  rwlock_acquire_read (inode_dir_lock (dir->inode));
   while (inode_read_at (dir->inode, &e, sizeof e, dir->pos) == sizeof e)
     {
       dir->pos += sizeof e;
       if (e.in_use)
         {
           strlcpy (name, e.name, NAME_MAX + 1);
-          return true;
+          found = true;
+          break;
         }
     }
-  return false;
+  rwlock_release_read (inode_dir_lock (dir->inode));
+  return found;
 }
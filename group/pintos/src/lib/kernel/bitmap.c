@@ -23,11 +23,18 @@ typedef unsigned long elem_type;
 
 /* From the outside, a bitmap is an array of bits.  From the
    inside, it's an array of elem_type (defined above) that
-   simulates an array of bits. */
+   simulates an array of bits.
+
+   Most operations work on whole elements at a time.  A bitmap
+   created with bitmap_create_with_summary() also has a summary
+   level with one bit per element, set when all of that element's
+   bits are true, which lets a search for false bits skip
+   ELEM_BITS * ELEM_BITS full bits at a time. */
 struct bitmap
   {
     size_t bit_cnt;     /* Number of bits. */
     elem_type *bits;    /* Elements that represent bits. */
+    elem_type *summary; /* One bit per full element, or null. */
   };
 
 /* Returns the index of the element that contains the bit
@@ -69,6 +76,139 @@ last_mask (const struct bitmap *b)
   return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
 
+/* Returns the number of bits set to 1 in X. */
+static inline unsigned
+popcount (elem_type x)
+{
+  x = x - ((x >> 1) & (elem_type) -1 / 3);
+  x = (x & (elem_type) -1 / 15 * 3) + ((x >> 2) & (elem_type) -1 / 15 * 3);
+  x = (x + (x >> 4)) & (elem_type) -1 / 255 * 15;
+  return (x * ((elem_type) -1 / 255)) >> (sizeof (elem_type) - 1) * CHAR_BIT;
+}
+
+/* Returns the index of the lowest bit set to 1 in X, which must
+   be nonzero. */
+static inline int
+ctz (elem_type x)
+{
+  return __builtin_ctzl (x);
+}
+
+/* Returns a bit mask in which the bits of element ELEM that
+   represent bits START through END, exclusive, are set to 1 and
+   the rest are set to 0. */
+static inline elem_type
+range_mask (size_t elem, size_t start, size_t end)
+{
+  size_t first = elem * ELEM_BITS;
+  elem_type mask = (elem_type) -1;
+
+  if (start > first)
+    mask &= (elem_type) -1 << (start - first);
+  if (end < first + ELEM_BITS)
+    mask &= ((elem_type) 1 << (end - first)) - 1;
+  return mask;
+}
+
+/* Atomically sets the bits in MASK in element ELEM of B. */
+static inline void
+elem_or (struct bitmap *b, size_t elem, elem_type mask)
+{
+  asm ("orl %1, %0" : "=m" (b->bits[elem]) : "r" (mask) : "cc");
+}
+
+/* Atomically clears the bits in MASK in element ELEM of B. */
+static inline void
+elem_and_not (struct bitmap *b, size_t elem, elem_type mask)
+{
+  asm ("andl %1, %0" : "=m" (b->bits[elem]) : "r" (~mask) : "cc");
+}
+
+/* Returns true if every bit in element ELEM of B is true. */
+static inline bool
+elem_full (const struct bitmap *b, size_t elem)
+{
+  elem_type full = (elem == elem_cnt (b->bit_cnt) - 1
+                    ? last_mask (b) : (elem_type) -1);
+  return (b->bits[elem] & full) == full;
+}
+
+/* Brings B's summary bit for element ELEM up to date, if B has a
+   summary.  The element may be changed concurrently, so after
+   writing the summary bit we check that it still matches and
+   try again if not; whoever changes the element last thus has
+   the last word. */
+static void
+update_summary (struct bitmap *b, size_t elem)
+{
+  if (b->summary != NULL)
+    {
+      size_t idx = elem_idx (elem);
+      elem_type mask = bit_mask (elem);
+      bool full;
+
+      do
+        {
+          full = elem_full (b, elem);
+          if (full)
+            asm ("orl %1, %0" : "=m" (b->summary[idx]) : "r" (mask) : "cc");
+          else
+            asm ("andl %1, %0" : "=m" (b->summary[idx]) : "r" (~mask) : "cc");
+        }
+      while (elem_full (b, elem) != full);
+    }
+}
+
+/* Returns the index of the first element at or after ELEM in B,
+   which must have a summary, that is not full, or a value of at
+   least elem_cnt (bitmap_size (B)) if there is none. */
+static size_t
+next_nonfull_elem (const struct bitmap *b, size_t elem)
+{
+  size_t last = elem_cnt (elem_cnt (b->bit_cnt));
+  size_t idx = elem_idx (elem);
+  elem_type nonfull;
+
+  if (idx >= last)
+    return elem;
+  nonfull = ~b->summary[idx] & ((elem_type) -1 << (elem % ELEM_BITS));
+  while (nonfull == 0)
+    {
+      if (++idx >= last)
+        return idx * ELEM_BITS;
+      nonfull = ~b->summary[idx];
+    }
+  return idx * ELEM_BITS + ctz (nonfull);
+}
+
+/* Returns the index of the first bit in B between START and END,
+   exclusive, that is set to VALUE, or END if there is none. */
+static size_t
+find_next (const struct bitmap *b, size_t start, size_t end, bool value)
+{
+  size_t elem;
+  elem_type bits;
+
+  if (start >= end)
+    return end;
+
+  elem = elem_idx (start);
+  bits = value ? b->bits[elem] : ~b->bits[elem];
+  bits &= (elem_type) -1 << (start % ELEM_BITS);
+  while (bits == 0)
+    {
+      elem++;
+      if (!value && b->summary != NULL)
+        elem = next_nonfull_elem (b, elem);
+      if (elem * ELEM_BITS >= end)
+        return end;
+      bits = value ? b->bits[elem] : ~b->bits[elem];
+    }
+
+  start = elem * ELEM_BITS + ctz (bits);
+  return start < end ? start : end;
+}
+
 /* Creation and destruction. */
 
 /* Creates and returns a pointer to a newly allocated bitmap with room for
@@ -83,6 +223,7 @@ bitmap_create (size_t bit_cnt)
     {
       b->bit_cnt = bit_cnt;
       b->bits = malloc (byte_cnt (bit_cnt));
+      b->summary = NULL;
       if (b->bits != NULL || bit_cnt == 0)
         {
           bitmap_set_all (b, false);
@@ -93,6 +234,29 @@ bitmap_create (size_t bit_cnt)
   return NULL;
 }
 
+/* Creates and returns a pointer to a newly allocated bitmap with
+   room for BIT_CNT (or more) bits, like bitmap_create(), that
+   also keeps a summary of which of its elements are full.  This
+   makes searching for false bits with bitmap_scan() much faster
+   on large, mostly true bitmaps, at the cost of a little more
+   work whenever bits change. */
+struct bitmap *
+bitmap_create_with_summary (size_t bit_cnt)
+{
+  struct bitmap *b = bitmap_create (bit_cnt);
+  if (b != NULL && bit_cnt > 0)
+    {
+      /* All bits are false, so no element is full. */
+      b->summary = calloc (elem_cnt (elem_cnt (bit_cnt)), sizeof (elem_type));
+      if (b->summary == NULL)
+        {
+          bitmap_destroy (b);
+          return NULL;
+        }
+    }
+  return b;
+}
+
 /* Creates and returns a bitmap with BIT_CNT bits in the
    BLOCK_SIZE bytes of storage preallocated at BLOCK.
    BLOCK_SIZE must be at least bitmap_needed_bytes(BIT_CNT). */
@@ -105,6 +269,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED)
 
   b->bit_cnt = bit_cnt;
   b->bits = (elem_type *) (b + 1);
+  b->summary = NULL;
   bitmap_set_all (b, false);
   return b;
 }
@@ -125,6 +290,7 @@ bitmap_destroy (struct bitmap *b)
   if (b != NULL)
     {
       free (b->bits);
+      free (b->summary);
       free (b);
     }
 }
@@ -163,6 +329,7 @@ bitmap_mark (struct bitmap *b, size_t bit_idx)
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the OR instruction in [IA32-v2b]. */
   asm ("orl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+  update_summary (b, idx);
 }
 
 /* Atomically sets the bit numbered BIT_IDX in B to false. */
@@ -176,6 +343,7 @@ bitmap_reset (struct bitmap *b, size_t bit_idx)
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the AND instruction in [IA32-v2a]. */
   asm ("andl %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+  update_summary (b, idx);
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -191,6 +359,7 @@ bitmap_flip (struct bitmap *b, size_t bit_idx)
      is guaranteed to be atomic on a uniprocessor machine.  See
      the description of the XOR instruction in [IA32-v2b]. */
   asm ("xorl %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+  update_summary (b, idx);
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -213,18 +382,30 @@ bitmap_set_all (struct bitmap *b, bool value)
   bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.
+   Each element's bits are set atomically, one element at a
+   time. */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value)
 {
+  size_t end = start + cnt;
   size_t i;
 
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    bitmap_set (b, start + i, value);
+  if (cnt == 0)
+    return;
+  for (i = elem_idx (start); i <= elem_idx (end - 1); i++)
+    {
+      elem_type mask = range_mask (i, start, end);
+      if (value)
+        elem_or (b, i, mask);
+      else
+        elem_and_not (b, i, mask);
+      update_summary (b, i);
+    }
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -232,6 +413,7 @@ bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value)
 size_t
 bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
 {
+  size_t end = start + cnt;
   size_t i, value_cnt;
 
   ASSERT (b != NULL);
@@ -239,9 +421,12 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
   ASSERT (start + cnt <= b->bit_cnt);
 
   value_cnt = 0;
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      value_cnt++;
+  if (cnt > 0)
+    for (i = elem_idx (start); i <= elem_idx (end - 1); i++)
+      {
+        elem_type bits = value ? b->bits[i] : ~b->bits[i];
+        value_cnt += popcount (bits & range_mask (i, start, end));
+      }
   return value_cnt;
 }
 
@@ -250,16 +435,11 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value)
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value)
 {
-  size_t i;
-
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
   ASSERT (start + cnt <= b->bit_cnt);
 
-  for (i = 0; i < cnt; i++)
-    if (bitmap_test (b, start + i) == value)
-      return true;
-  return false;
+  return find_next (b, start, start + cnt, value) < start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -298,13 +478,27 @@ bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value)
   ASSERT (b != NULL);
   ASSERT (start <= b->bit_cnt);
 
+  if (cnt == 0)
+    return start;
   if (cnt <= b->bit_cnt)
     {
       size_t last = b->bit_cnt - cnt;
-      size_t i;
-      for (i = start; i <= last; i++)
-        if (!bitmap_contains (b, i, cnt, !value))
-          return i;
+      size_t i = start;
+      while (i <= last)
+        {
+          /* Find the next bit set to VALUE, then see whether the
+             run it starts is long enough.  If not, resume the
+             search after the bit that ends the run. */
+          size_t run_end;
+
+          i = find_next (b, i, last + 1, value);
+          if (i > last)
+            break;
+          run_end = find_next (b, i, i + cnt, !value);
+          if (run_end == i + cnt)
+            return i;
+          i = run_end + 1;
+        }
     }
   return BITMAP_ERROR;
 }
@@ -335,6 +529,17 @@ bitmap_file_size (const struct bitmap *b)
   return byte_cnt (b->bit_cnt);
 }
 
+/* Recomputes all of B's summary bits, if B has a summary. */
+static void
+rebuild_summary (struct bitmap *b)
+{
+  size_t i;
+
+  if (b->summary != NULL)
+    for (i = 0; i < elem_cnt (b->bit_cnt); i++)
+      update_summary (b, i);
+}
+
 /* Reads B from FILE.  Returns true if successful, false
    otherwise. */
 bool
@@ -346,6 +551,7 @@ bitmap_read (struct bitmap *b, struct file *file)
       off_t size = byte_cnt (b->bit_cnt);
       success = file_read_at (file, b->bits, size, 0) == size;
       b->bits[elem_cnt (b->bit_cnt) - 1] &= last_mask (b);
+      rebuild_summary (b);
     }
   return success;
 }
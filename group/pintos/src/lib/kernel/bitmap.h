@@ -9,6 +9,7 @@
 
 /* Creation and destruction. */
 struct bitmap *bitmap_create (size_t bit_cnt);
+struct bitmap *bitmap_create_with_summary (size_t bit_cnt);
 struct bitmap *bitmap_create_in_buf (size_t bit_cnt, void *, size_t byte_cnt);
 size_t bitmap_buf_size (size_t bit_cnt);
 void bitmap_destroy (struct bitmap *);
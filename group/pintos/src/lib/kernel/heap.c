@@ -0,0 +1,266 @@
+#include "heap.h"
+#include "../debug.h"
+
+/* A pairing heap is a tree in which every node comes out of the
+   heap no later than any of its children.  Each node keeps its
+   children in a doubly linked list: `child' points to the
+   leftmost child, `next' to the next sibling, and `prev' to the
+   previous sibling or, for the leftmost child, to the parent.
+   The root has no siblings.
+
+   Two heaps are melded by making the root that comes out later
+   the leftmost child of the other one.  Removing the root melds
+   its children in pairs from left to right and then melds the
+   resulting heaps from right to left, which is what gives the
+   structure its amortized logarithmic bound. */
+
+/* Returns true if A should come out of heap H before B.  Ties
+   are broken in favor of the element that was inserted first. */
+static inline bool
+before (const struct heap *h, const struct heap_elem *a,
+        const struct heap_elem *b)
+{
+  if (h->less (a, b, h->aux))
+    return true;
+  if (h->less (b, a, h->aux))
+    return false;
+  return (int) (a->seq - b->seq) < 0;
+}
+
+/* Melds the heaps rooted at A and B, which must not have
+   siblings, and returns the root of the result. */
+static struct heap_elem *
+meld (const struct heap *h, struct heap_elem *a, struct heap_elem *b)
+{
+  struct heap_elem *tmp;
+
+  if (before (h, b, a))
+    {
+      tmp = a;
+      a = b;
+      b = tmp;
+    }
+
+  b->next = a->child;
+  if (a->child != NULL)
+    a->child->prev = b;
+  b->prev = a;
+  a->child = b;
+  return a;
+}
+
+/* Melds the list of sibling heaps starting at FIRST into a
+   single heap and returns its root, or a null pointer if FIRST
+   is null. */
+static struct heap_elem *
+merge_pairs (const struct heap *h, struct heap_elem *first)
+{
+  struct heap_elem *pairs = NULL;
+  struct heap_elem *root = NULL;
+
+  /* Left to right: meld adjacent pairs, collecting the results
+     in reverse order through their `next' links. */
+  while (first != NULL)
+    {
+      struct heap_elem *a = first;
+      struct heap_elem *b = a->next;
+
+      first = b != NULL ? b->next : NULL;
+      a->next = a->prev = NULL;
+      if (b != NULL)
+        {
+          b->next = b->prev = NULL;
+          a = meld (h, a, b);
+        }
+      a->next = pairs;
+      pairs = a;
+    }
+
+  /* Right to left: meld each pair into the accumulated heap. */
+  while (pairs != NULL)
+    {
+      struct heap_elem *next = pairs->next;
+      pairs->next = NULL;
+      root = root != NULL ? meld (h, root, pairs) : pairs;
+      pairs = next;
+    }
+
+  if (root != NULL)
+    root->next = root->prev = NULL;
+  return root;
+}
+
+/* Initializes H as an empty heap ordered by LESS given auxiliary
+   data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux)
+{
+  ASSERT (h != NULL);
+  ASSERT (less != NULL);
+
+  h->root = NULL;
+  h->size = 0;
+  h->next_seq = 0;
+  h->less = less;
+  h->aux = aux;
+}
+
+/* Adds E, whose sequence number has already been set, to H as
+   a heap of its own. */
+static void
+link (struct heap *h, struct heap_elem *e)
+{
+  e->child = e->next = e->prev = NULL;
+  h->root = h->root != NULL ? meld (h, h->root, e) : e;
+  h->root->next = h->root->prev = NULL;
+  h->size++;
+}
+
+/* Inserts E into H. */
+void
+heap_insert (struct heap *h, struct heap_elem *e)
+{
+  ASSERT (h != NULL);
+  ASSERT (e != NULL);
+
+  e->seq = h->next_seq++;
+  link (h, e);
+}
+
+/* Removes E, which must be in H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e)
+{
+  struct heap_elem *sub;
+
+  ASSERT (h != NULL);
+  ASSERT (e != NULL);
+  ASSERT (h->size > 0);
+
+  if (e == h->root)
+    {
+      heap_pop_min (h);
+      return;
+    }
+
+  /* Unlink E from its parent's list of children. */
+  if (e->prev->child == e)
+    e->prev->child = e->next;
+  else
+    e->prev->next = e->next;
+  if (e->next != NULL)
+    e->next->prev = e->prev;
+
+  /* Put E's children back into the heap. */
+  sub = merge_pairs (h, e->child);
+  if (sub != NULL)
+    h->root = meld (h, h->root, sub);
+  h->size--;
+}
+
+/* Restores the order of H after the key of E, which must be in
+   H, has changed.  E keeps its original insertion order relative
+   to the elements that compare equal to it. */
+void
+heap_update (struct heap *h, struct heap_elem *e)
+{
+  ASSERT (h != NULL);
+  ASSERT (e != NULL);
+
+  heap_remove (h, e);
+  link (h, e);
+}
+
+/* Calls ACTION for each element of H, in no particular order,
+   then restores the order of H, since ACTION may change the key
+   of any of them.  Elements keep their original insertion order
+   relative to the elements that compare equal to them.  Takes
+   linear time, so it is cheaper than calling heap_update() on
+   each element. */
+void
+heap_update_all (struct heap *h, heap_action_func *action, void *aux)
+{
+  struct heap_elem *work, *all;
+
+  ASSERT (h != NULL);
+  ASSERT (action != NULL);
+
+  /* Flatten the tree into a list threaded through the `prev'
+     links, using the `next' links as a work list. */
+  work = h->root;
+  all = NULL;
+  while (work != NULL)
+    {
+      struct heap_elem *e = work;
+
+      work = e->next;
+      if (e->child != NULL)
+        {
+          struct heap_elem *last = e->child;
+
+          while (last->next != NULL)
+            last = last->next;
+          last->next = work;
+          work = e->child;
+        }
+      e->prev = all;
+      all = e;
+    }
+
+  h->root = NULL;
+  h->size = 0;
+  while (all != NULL)
+    {
+      struct heap_elem *e = all;
+
+      all = e->prev;
+      action (e, aux);
+      link (h, e);
+    }
+}
+
+/* Removes and returns the minimum element of H, or returns a
+   null pointer if H is empty. */
+struct heap_elem *
+heap_pop_min (struct heap *h)
+{
+  struct heap_elem *min;
+
+  ASSERT (h != NULL);
+
+  min = h->root;
+  if (min != NULL)
+    {
+      h->root = merge_pairs (h, min->child);
+      h->size--;
+    }
+  return min;
+}
+
+/* Returns the minimum element of H without removing it, or a
+   null pointer if H is empty. */
+struct heap_elem *
+heap_min (const struct heap *h)
+{
+  ASSERT (h != NULL);
+
+  return h->root;
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (const struct heap *h)
+{
+  ASSERT (h != NULL);
+
+  return h->size;
+}
+
+/* Returns true if H is empty, false otherwise. */
+bool
+heap_empty (const struct heap *h)
+{
+  ASSERT (h != NULL);
+
+  return h->root == NULL;
+}
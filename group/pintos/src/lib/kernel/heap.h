@@ -0,0 +1,78 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Priority queue.
+
+   This is a pairing heap.  Like our lists and hash tables, it
+   does not use dynamically allocated memory.  Each structure
+   that can potentially be in a heap must embed a struct
+   heap_elem member, and the heap_entry macro converts a struct
+   heap_elem back to the structure that contains it.  Refer to
+   lib/kernel/list.h for a detailed explanation of the technique.
+
+   Insertion and finding the minimum take constant time.
+   Removing the minimum, removing an arbitrary element, or
+   restoring the order after an element's key changes takes
+   amortized logarithmic time.
+
+   The order of elements is given by a heap_less_func.  Elements
+   that compare equal come out of the heap in the order they were
+   inserted, so a heap of threads keyed by priority, for example,
+   is FIFO within each priority. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem
+  {
+    struct heap_elem *child;    /* Leftmost child. */
+    struct heap_elem *next;     /* Next sibling. */
+    struct heap_elem *prev;     /* Previous sibling, or parent for
+                                   the leftmost child. */
+    unsigned seq;               /* Insertion order, to break ties. */
+  };
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+   the structure that HEAP_ELEM is embedded inside.  Supply the
+   name of the outer structure STRUCT and the member name MEMBER
+   of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+        ((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->child    \
+                     - offsetof (STRUCT, MEMBER.child)))
+
+/* Compares the value of two heap elements A and B, given
+   auxiliary data AUX.  Returns true if A should come out of the
+   heap before B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+                             const struct heap_elem *b,
+                             void *aux);
+
+/* Performs some operation on heap element E, given auxiliary
+   data AUX. */
+typedef void heap_action_func (struct heap_elem *e, void *aux);
+
+/* Heap. */
+struct heap
+  {
+    struct heap_elem *root;     /* Minimum element, or null. */
+    size_t size;                /* Number of elements. */
+    unsigned next_seq;          /* Sequence number for next insert. */
+    heap_less_func *less;       /* Comparison function. */
+    void *aux;                  /* Auxiliary data for `less'. */
+  };
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+void heap_insert (struct heap *, struct heap_elem *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_update (struct heap *, struct heap_elem *);
+void heap_update_all (struct heap *, heap_action_func *, void *aux);
+struct heap_elem *heap_pop_min (struct heap *);
+struct heap_elem *heap_min (const struct heap *);
+
+size_t heap_size (const struct heap *);
+bool heap_empty (const struct heap *);
+
+#endif /* lib/kernel/heap.h */
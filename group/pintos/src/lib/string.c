@@ -1,5 +1,67 @@
 #include <string.h>
 #include <debug.h>
+#include <stdint.h>
+
+/* The block operations below move 32-bit words at a time, using
+   the x86 string instructions where they help.  These expect the
+   direction flag to be clear, as it always is on function entry;
+   whatever sets it must clear it again before calling out.
+
+   A word that may be unaligned, or may alias any other type. */
+typedef uint32_t word_t __attribute__ ((may_alias, aligned (1)));
+
+/* Blocks shorter than this are handled a byte at a time, because
+   aligning the destination first would not pay off. */
+#define SHORT_BLOCK 16
+
+/* Copies SIZE bytes from SRC to DST, going upward. */
+static inline void
+copy_up (unsigned char *dst, const unsigned char *src, size_t size)
+{
+  if (size >= SHORT_BLOCK)
+    {
+      /* Align DST to a word boundary, then copy whole words. */
+      size_t head = -(uintptr_t) dst & 3;
+      size_t words = (size - head) / 4;
+
+      size = (size - head) % 4;
+      asm volatile ("rep movsb"
+                    : "+D" (dst), "+S" (src), "+c" (head) : : "memory");
+      asm volatile ("rep movsl"
+                    : "+D" (dst), "+S" (src), "+c" (words) : : "memory");
+    }
+  asm volatile ("rep movsb"
+                : "+D" (dst), "+S" (src), "+c" (size) : : "memory");
+}
+
+/* Copies SIZE bytes from SRC to DST, going downward, so that DST
+   may overlap the end of SRC. */
+static inline void
+copy_down (unsigned char *dst, const unsigned char *src, size_t size)
+{
+  size_t bytes = size % 4;
+  size_t words = size / 4;
+
+  if (size == 0)
+    return;
+
+  /* Copy the odd bytes at the end, then whole words, with the
+     direction flag set.  It all has to be one asm statement so
+     that the compiler cannot put code of its own between setting
+     and clearing the flag. */
+  dst += size - 1;
+  src += size - 1;
+  asm volatile ("std\n\t"
+                "rep movsb\n\t"
+                "subl $3, %%edi\n\t"
+                "subl $3, %%esi\n\t"
+                "movl %3, %%ecx\n\t"
+                "rep movsl\n\t"
+                "cld"
+                : "+D" (dst), "+S" (src), "+c" (bytes)
+                : "r" (words)
+                : "memory", "cc");
+}
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
    Returns DST. */
@@ -12,8 +74,7 @@ memcpy (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
-  while (size-- > 0)
-    *dst++ = *src++;
+  copy_up (dst, src, size);
 
   return dst_;
 }
@@ -29,20 +90,12 @@ memmove (void *dst_, const void *src_, size_t size)
   ASSERT (dst != NULL || size == 0);
   ASSERT (src != NULL || size == 0);
 
-  if (dst < src)
-    {
-      while (size-- > 0)
-        *dst++ = *src++;
-    }
+  if (dst <= src || dst >= src + size)
+    copy_up (dst, src, size);
   else
-    {
-      dst += size;
-      src += size;
-      while (size-- > 0)
-        *--dst = *--src;
-    }
+    copy_down (dst, src, size);
 
-  return dst;
+  return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
@@ -58,6 +111,10 @@ memcmp (const void *a_, const void *b_, size_t size)
   ASSERT (a != NULL || size == 0);
   ASSERT (b != NULL || size == 0);
 
+  /* Skip over equal words, then find the differing byte. */
+  for (; size >= 4; a += 4, b += 4, size -= 4)
+    if (*(const word_t *) a != *(const word_t *) b)
+      break;
   for (; size-- > 0; a++, b++)
     if (*a != *b)
       return *a > *b ? +1 : -1;
@@ -282,8 +339,21 @@ memset (void *dst_, int value, size_t size)
 
   ASSERT (dst != NULL || size == 0);
 
-  while (size-- > 0)
-    *dst++ = value;
+  if (size >= SHORT_BLOCK)
+    {
+      /* Align DST to a word boundary, then store whole words. */
+      size_t head = -(uintptr_t) dst & 3;
+      size_t words = (size - head) / 4;
+      uint32_t pattern = (unsigned char) value * 0x01010101u;
+
+      size = (size - head) % 4;
+      asm volatile ("rep stosb"
+                    : "+D" (dst), "+c" (head) : "a" (value) : "memory");
+      asm volatile ("rep stosl"
+                    : "+D" (dst), "+c" (words) : "a" (pattern) : "memory");
+    }
+  asm volatile ("rep stosb"
+                : "+D" (dst), "+c" (size) : "a" (value) : "memory");
 
   return dst_;
 }
@@ -293,10 +363,25 @@ size_t
 strlen (const char *string)
 {
   const char *p;
+  const word_t *w;
 
   ASSERT (string != NULL);
 
-  for (p = string; *p != '\0'; p++)
+  /* Check bytes up to a word boundary. */
+  for (p = string; (uintptr_t) p % 4 != 0; p++)
+    if (*p == '\0')
+      return p - string;
+
+  /* Check a word at a time.  An aligned word never crosses a
+     page boundary, so reading past the terminator is safe.
+     (W - 0x01010101) & ~W & 0x80808080 is nonzero if and only if
+     some byte in W is zero. */
+  for (w = (const word_t *) p;
+       ((*w - 0x01010101) & ~*w & 0x80808080) == 0; w++)
+    continue;
+
+  /* Find the null byte within the word. */
+  for (p = (const char *) w; *p != '\0'; p++)
     continue;
   return p - string;
 }
@@ -0,0 +1,71 @@
+#ifndef __LIB_SYSCALL_RING_H
+#define __LIB_SYSCALL_RING_H
+
+#include <stdint.h>
+
+/* System call rings.
+
+   A process that makes many small system calls can queue them in
+   a submission ring instead and have the kernel carry out a
+   whole batch of them in one ring_enter() system call, which
+   posts each one's result in a completion ring.  Both rings are
+   in the process's own memory, registered with the kernel by
+   ring_setup(), so queueing calls and reaping results take no
+   traps at all.
+
+   Each ring is a circular array of RING_SIZE entries with a head
+   and a tail index.  The indexes count up forever and are taken
+   modulo RING_SIZE only to find an entry, so a ring holds TAIL -
+   HEAD entries.  The process adds entries at the tail of the
+   submission ring and removes them from the head of the
+   completion ring.  The kernel does the opposite.
+
+   lib/user/ring.h has a friendlier interface. */
+
+/* Entries in each ring.  Must be a power of 2. */
+#define RING_SIZE 64
+
+/* Operations that can be submitted. */
+enum ring_op
+  {
+    RING_READ,                  /* read (FD, BUFFER, SIZE). */
+    RING_WRITE,                 /* write (FD, BUFFER, SIZE). */
+    RING_OPEN,                  /* open (BUFFER). */
+    RING_CLOSE,                 /* close (FD). */
+    RING_SEEK                   /* seek (FD, SIZE). */
+  };
+
+/* Submission ring entry. */
+struct ring_sqe
+  {
+    uint32_t op;                /* A RING_* operation. */
+    int32_t fd;                 /* File descriptor. */
+    void *buffer;               /* Data buffer, or file name to open. */
+    uint32_t size;              /* Bytes to transfer, or seek position. */
+    uint32_t user_data;         /* Passed through to the completion. */
+  };
+
+/* Completion ring entry. */
+struct ring_cqe
+  {
+    uint32_t user_data;         /* From the submission. */
+    int32_t result;             /* What the system call returned. */
+  };
+
+/* Submission ring. */
+struct sq_ring
+  {
+    uint32_t head;              /* Next entry for the kernel. */
+    uint32_t tail;              /* Next free entry for the process. */
+    struct ring_sqe sqes[RING_SIZE];
+  };
+
+/* Completion ring. */
+struct cq_ring
+  {
+    uint32_t head;              /* Next entry for the process. */
+    uint32_t tail;              /* Next free entry for the kernel. */
+    struct ring_cqe cqes[RING_SIZE];
+  };
+
+#endif /* lib/syscall-ring.h */
@@ -0,0 +1,96 @@
+#include "ring.h"
+#include <syscall.h>
+
+/* This process's rings. */
+static struct sq_ring sq;
+static struct cq_ring cq;
+
+static bool queue (enum ring_op, int fd, void *buffer, unsigned size,
+                   uint32_t user_data);
+
+/* Registers this process's rings with the kernel.  Must be
+   called before any other function here.  Returns true if
+   successful. */
+bool
+ring_init (void)
+{
+  return ring_setup (&sq, &cq);
+}
+
+/* Queues read (FD, BUFFER, SIZE). */
+bool
+ring_read (int fd, void *buffer, unsigned size, uint32_t user_data)
+{
+  return queue (RING_READ, fd, buffer, size, user_data);
+}
+
+/* Queues write (FD, BUFFER, SIZE). */
+bool
+ring_write (int fd, const void *buffer, unsigned size, uint32_t user_data)
+{
+  return queue (RING_WRITE, fd, (void *) buffer, size, user_data);
+}
+
+/* Queues open (FILE).  FILE must stay put until the call has
+   been carried out. */
+bool
+ring_open (const char *file, uint32_t user_data)
+{
+  return queue (RING_OPEN, -1, (void *) file, 0, user_data);
+}
+
+/* Queues close (FD). */
+bool
+ring_close (int fd, uint32_t user_data)
+{
+  return queue (RING_CLOSE, fd, NULL, 0, user_data);
+}
+
+/* Queues seek (FD, POSITION). */
+bool
+ring_seek (int fd, unsigned position, uint32_t user_data)
+{
+  return queue (RING_SEEK, fd, NULL, position, user_data);
+}
+
+/* Has the kernel carry out the queued calls, in order, and
+   returns how many it did.  It stops early if the completion
+   ring fills up, in which case the caller should reap some
+   results and submit again. */
+int
+ring_submit (void)
+{
+  return ring_enter (sq.tail - sq.head);
+}
+
+/* Removes the oldest result from the completion ring and stores
+   it in CQE.  Returns false if there are no results. */
+bool
+ring_reap (struct ring_cqe *cqe)
+{
+  if (cq.head == cq.tail)
+    return false;
+  *cqe = cq.cqes[cq.head % RING_SIZE];
+  cq.head++;
+  return true;
+}
+
+/* Adds a submission entry to the submission ring.  Returns false
+   if the ring is full. */
+static bool
+queue (enum ring_op op, int fd, void *buffer, unsigned size,
+       uint32_t user_data)
+{
+  struct ring_sqe *sqe;
+
+  if (sq.tail - sq.head >= RING_SIZE)
+    return false;
+  sqe = &sq.sqes[sq.tail % RING_SIZE];
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->buffer = buffer;
+  sqe->size = size;
+  sqe->user_data = user_data;
+  sq.tail++;
+  return true;
+}
@@ -0,0 +1,25 @@
+#ifndef __LIB_USER_RING_H
+#define __LIB_USER_RING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <syscall-ring.h>
+
+/* Batched system calls through the rings in lib/syscall-ring.h.
+
+   The ring_read() through ring_seek() functions each queue a
+   call, tagged with USER_DATA, and return false if the queue is
+   full.  ring_submit() has the kernel carry out the queued
+   calls, and ring_reap() retrieves their results. */
+
+bool ring_init (void);
+bool ring_read (int fd, void *buffer, unsigned size, uint32_t user_data);
+bool ring_write (int fd, const void *buffer, unsigned size,
+                 uint32_t user_data);
+bool ring_open (const char *file, uint32_t user_data);
+bool ring_close (int fd, uint32_t user_data);
+bool ring_seek (int fd, unsigned position, uint32_t user_data);
+int ring_submit (void);
+bool ring_reap (struct ring_cqe *);
+
+#endif /* lib/user/ring.h */
@@ -2,6 +2,7 @@
 #define __LIB_USER_SYSCALL_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <debug.h>
 
 /* Process identifier. */
@@ -12,6 +13,17 @@ typedef int pid_t;
 typedef int mapid_t;
 #define MAP_FAILED ((mapid_t) -1)
 
+/* A buffer for readv() and writev(). */
+struct iovec
+  {
+    void *iov_base;             /* Start of buffer. */
+    size_t iov_len;             /* Size of buffer in bytes. */
+  };
+
+/* System call rings, see lib/syscall-ring.h. */
+struct sq_ring;
+struct cq_ring;
+
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
@@ -34,6 +46,14 @@ void seek (int fd, unsigned position);
 unsigned tell (int fd);
 void close (int fd);
 int practice (int i);
+int pread (int fd, void *buffer, unsigned length, unsigned offset);
+int pwrite (int fd, const void *buffer, unsigned length, unsigned offset);
+int readv (int fd, const struct iovec *, int iovcnt);
+int writev (int fd, const struct iovec *, int iovcnt);
+bool ring_setup (struct sq_ring *, struct cq_ring *);
+int ring_enter (unsigned to_submit);
+bool pipe (int fds[2]);
+int dup2 (int oldfd, int newfd);
 
 /* Project 3 and optionally project 4. */
 mapid_t mmap (int fd, void *addr);
@@ -0,0 +1,53 @@
+/* Child process for syn-rw-rate test.
+   Writes a file of its own a chunk at a time and reads it back,
+   several times over.  Other processes will be doing the same
+   with other files at the same time. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/filesys/base/syn-rw.h"
+
+const char *test_name = "child-syn-rw";
+
+static char buf[CHUNK_SIZE];
+static char expected[CHUNK_SIZE];
+
+int
+main (int argc, char *argv[])
+{
+  char file_name[16];
+  int child_idx;
+  int fd;
+  size_t pass, ofs;
+
+  quiet = true;
+
+  CHECK (argc == 2, "argc must be 2, actually %d", argc);
+  child_idx = atoi (argv[1]);
+  snprintf (file_name, sizeof file_name, "rw%d", child_idx);
+
+  CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
+  for (pass = 0; pass < PASS_CNT; pass++)
+    {
+      memset (expected, child_idx * PASS_CNT + pass, sizeof expected);
+
+      seek (fd, 0);
+      for (ofs = 0; ofs < FILE_SIZE; ofs += CHUNK_SIZE)
+        CHECK (write (fd, expected, CHUNK_SIZE) == CHUNK_SIZE,
+               "write \"%s\"", file_name);
+
+      seek (fd, 0);
+      for (ofs = 0; ofs < FILE_SIZE; ofs += CHUNK_SIZE)
+        {
+          CHECK (read (fd, buf, CHUNK_SIZE) == CHUNK_SIZE,
+                 "read \"%s\"", file_name);
+          compare_bytes (buf, expected, CHUNK_SIZE, ofs, file_name);
+        }
+    }
+  close (fd);
+
+  return child_idx;
+}
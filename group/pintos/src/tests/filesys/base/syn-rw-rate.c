@@ -0,0 +1,65 @@
+/* Runs CHILD_CNT child processes that each write and read back a
+   file of their own, first one after another and then all at
+   once, and reports the file system throughput of both runs.
+   Children that run at once only contend for the file system if
+   it serializes operations on unrelated files. */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/filesys/base/syn-rw.h"
+
+/* Bytes that the children read and write in one run. */
+#define RUN_BYTES ((uint64_t) CHILD_CNT * PASS_CNT * FILE_SIZE * 2)
+
+/* Runs the children, all at once if PARALLEL is true, otherwise
+   one at a time, and returns how many bytes they transferred per
+   million cycles. */
+static unsigned
+run_children (bool parallel)
+{
+  pid_t children[CHILD_CNT];
+  uint64_t start, cycles;
+  size_t i;
+
+  quiet = true;
+  start = rdtsc ();
+  if (parallel)
+    {
+      exec_children ("child-syn-rw", children, CHILD_CNT);
+      wait_children (children, CHILD_CNT);
+    }
+  else
+    for (i = 0; i < CHILD_CNT; i++)
+      {
+        char cmd_line[32];
+
+        snprintf (cmd_line, sizeof cmd_line, "child-syn-rw %zu", i);
+        CHECK ((children[i] = exec (cmd_line)) != PID_ERROR,
+               "exec \"%s\"", cmd_line);
+        CHECK (wait (children[i]) == (int) i, "wait for \"%s\"", cmd_line);
+      }
+  cycles = rdtsc () - start;
+  quiet = false;
+
+  return RUN_BYTES * 1000000 / (cycles > 0 ? cycles : 1);
+}
+
+void
+test_main (void)
+{
+  char file_name[16];
+  size_t i;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      snprintf (file_name, sizeof file_name, "rw%zu", i);
+      CHECK (create (file_name, FILE_SIZE), "create \"%s\"", file_name);
+    }
+
+  msg ("one at a time: %u bytes per million cycles", run_children (false));
+  msg ("all at once: %u bytes per million cycles", run_children (true));
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+s/^\(syn-rw-rate\) (.*): \d+ bytes per million cycles$/(syn-rw-rate) $1: N bytes per million cycles/
+  foreach @output;
+compare_output ("run", IGNORE_EXIT_CODES => 1, \@output, [<<'EOF']);
+(syn-rw-rate) begin
+(syn-rw-rate) create "rw0"
+(syn-rw-rate) create "rw1"
+(syn-rw-rate) create "rw2"
+(syn-rw-rate) create "rw3"
+(syn-rw-rate) one at a time: N bytes per million cycles
+(syn-rw-rate) all at once: N bytes per million cycles
+(syn-rw-rate) end
+EOF
+pass;
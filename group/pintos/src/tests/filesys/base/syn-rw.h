@@ -0,0 +1,9 @@
+#ifndef TESTS_FILESYS_BASE_SYN_RW_H
+#define TESTS_FILESYS_BASE_SYN_RW_H
+
+#define CHILD_CNT 4
+#define CHUNK_SIZE 512
+#define FILE_SIZE (32 * CHUNK_SIZE)
+#define PASS_CNT 4
+
+#endif /* tests/filesys/base/syn-rw.h */
@@ -0,0 +1,179 @@
+/* Test program for lib/kernel/bitmap.c.
+
+   Checks the bitmap operations against a plain array of bools,
+   for bitmaps with and without a summary level, and then times
+   bitmap_scan(), bitmap_count() and bitmap_set_multiple() on a
+   large bitmap.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <bitmap.h>
+#include <debug.h>
+#include <random.h>
+#include <stdio.h>
+#include "threads/test.h"
+#include "threads/tsc.h"
+
+/* Largest bitmap whose operations we check. */
+#define MAX_BITS 1024
+
+/* Size of the bitmap that we time, about a 512 MB disk's worth
+   of sectors. */
+#define BENCH_BITS (1024 * 1024)
+
+static void check (bool summary);
+static size_t scan_slowly (const bool[], size_t bit_cnt,
+                           size_t start, size_t cnt, bool value);
+static void bench (bool summary);
+
+/* Test the bitmap implementation. */
+void
+test (void)
+{
+  check (false);
+  check (true);
+  bench (false);
+  bench (true);
+  printf ("bitmap: PASS\n");
+}
+
+/* Checks random operations on bitmaps of various sizes, with a
+   summary level if SUMMARY is true. */
+static void
+check (bool summary)
+{
+  size_t bit_cnt;
+
+  printf ("testing various size bitmaps%s:",
+          summary ? " with summary" : "");
+  for (bit_cnt = 0; bit_cnt <= MAX_BITS; bit_cnt = bit_cnt * 3 / 2 + 1)
+    {
+      static bool bits[MAX_BITS];
+      struct bitmap *b;
+      int repeat;
+      size_t i;
+
+      printf (" %zu", bit_cnt);
+      b = summary ? bitmap_create_with_summary (bit_cnt)
+                  : bitmap_create (bit_cnt);
+      ASSERT (b != NULL);
+      for (i = 0; i < bit_cnt; i++)
+        bits[i] = false;
+
+      for (repeat = 0; repeat < 1000; repeat++)
+        {
+          size_t start = random_ulong () % (bit_cnt + 1);
+          size_t cnt = random_ulong () % (bit_cnt - start + 1);
+          bool value = random_ulong () % 4 != 0;
+          size_t value_cnt = 0;
+          bool contains = false;
+
+          switch (random_ulong () % 3)
+            {
+            case 0:
+              bitmap_set_multiple (b, start, cnt, value);
+              for (i = start; i < start + cnt; i++)
+                bits[i] = value;
+              break;
+
+            case 1:
+              if (bit_cnt > 0)
+                {
+                  i = random_ulong () % bit_cnt;
+                  bitmap_flip (b, i);
+                  bits[i] = !bits[i];
+                }
+              break;
+
+            case 2:
+              for (i = start; i < start + cnt; i++)
+                if (bits[i] == value)
+                  {
+                    value_cnt++;
+                    contains = true;
+                  }
+              ASSERT (bitmap_count (b, start, cnt, value) == value_cnt);
+              ASSERT (bitmap_contains (b, start, cnt, value) == contains);
+              break;
+            }
+
+          cnt = random_ulong () % 8 == 0 ? random_ulong () % 64
+                                         : random_ulong () % 4;
+          ASSERT (bitmap_scan (b, start, cnt, !value)
+                  == scan_slowly (bits, bit_cnt, start, cnt, !value));
+        }
+
+      for (i = 0; i < bit_cnt; i++)
+        ASSERT (bitmap_test (b, i) == bits[i]);
+      bitmap_destroy (b);
+    }
+  printf (" done\n");
+}
+
+/* Returns what bitmap_scan() should return for a bitmap with
+   BIT_CNT bits that are stored in BITS. */
+static size_t
+scan_slowly (const bool bits[], size_t bit_cnt,
+             size_t start, size_t cnt, bool value)
+{
+  size_t i, j;
+
+  if (cnt == 0)
+    return start;
+  for (i = start; i + cnt <= bit_cnt; i++)
+    {
+      for (j = 0; j < cnt; j++)
+        if (bits[i + j] != value)
+          break;
+      if (j == cnt)
+        return i;
+    }
+  return BITMAP_ERROR;
+}
+
+/* Times bitmap operations on a bitmap of BENCH_BITS bits, with a
+   summary level if SUMMARY is true.  The bitmap is filled except
+   for a few bits near its end, as a disk's free map is when the
+   disk is nearly full. */
+static void
+bench (bool summary)
+{
+  struct bitmap *b;
+  uint64_t start;
+  size_t idx;
+  int i;
+
+  b = summary ? bitmap_create_with_summary (BENCH_BITS)
+              : bitmap_create (BENCH_BITS);
+  ASSERT (b != NULL);
+
+  start = rdtsc ();
+  for (i = 0; i < 10; i++)
+    bitmap_set_multiple (b, 0, BENCH_BITS, i % 2 != 0);
+  printf ("bitmap%s: set_multiple %llu cycles per call\n",
+          summary ? " with summary" : "",
+          (unsigned long long) (rdtsc () - start) / 10);
+  bitmap_set_multiple (b, BENCH_BITS - 100, 10, false);
+
+  start = rdtsc ();
+  for (i = 0; i < 10; i++)
+    ASSERT (bitmap_count (b, 0, BENCH_BITS, false) == 10);
+  printf ("bitmap%s: count %llu cycles per call\n",
+          summary ? " with summary" : "",
+          (unsigned long long) (rdtsc () - start) / 10);
+
+  start = rdtsc ();
+  for (i = 0; i < 10; i++)
+    {
+      idx = bitmap_scan (b, 0, 8, false);
+      ASSERT (idx == BENCH_BITS - 100);
+    }
+  printf ("bitmap%s: scan %llu cycles per call\n",
+          summary ? " with summary" : "",
+          (unsigned long long) (rdtsc () - start) / 10);
+
+  bitmap_destroy (b);
+}
@@ -0,0 +1,238 @@
+/* Test program for the block and string routines in
+   lib/string.c.
+
+   Checks memcpy(), memmove(), memset(), memcmp() and strlen()
+   against simple byte-at-a-time versions, then compares the
+   throughput of both at several sizes and alignments.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/test.h"
+#include "threads/tsc.h"
+
+/* Largest block that we test or time. */
+#define MAX_SIZE 4096
+
+/* Times each timed operation is repeated. */
+#define REPEAT 64
+
+static unsigned char buf_a[MAX_SIZE + 8], buf_b[MAX_SIZE + 8];
+static unsigned char ref_b[MAX_SIZE + 8];
+
+static void check (void);
+static void bench (void);
+static void byte_memmove (unsigned char *, const unsigned char *, size_t);
+static int byte_memcmp (const unsigned char *, const unsigned char *,
+                        size_t);
+static int sign (int);
+
+/* Test the string implementation. */
+void
+test (void)
+{
+  check ();
+  bench ();
+  printf ("string: PASS\n");
+}
+
+/* Checks the routines on random blocks of random sizes at random
+   offsets. */
+static void
+check (void)
+{
+  int repeat;
+
+  printf ("testing random blocks:");
+  for (repeat = 0; repeat < 10000; repeat++)
+    {
+      size_t size = random_ulong () % (random_ulong () % 4 ? 64 : MAX_SIZE);
+      size_t src = random_ulong () % 8;
+      size_t dst = random_ulong () % 8;
+      int value = random_ulong ();
+      size_t i;
+
+      random_bytes (buf_a, sizeof buf_a);
+      random_bytes (buf_b, sizeof buf_b);
+      memcpy (ref_b, buf_b, sizeof buf_b);
+
+      switch (random_ulong () % 5)
+        {
+        case 0:
+          ASSERT (memcpy (buf_b + dst, buf_a + src, size) == buf_b + dst);
+          byte_memmove (ref_b + dst, buf_a + src, size);
+          break;
+
+        case 1:
+          ASSERT (memmove (buf_b + dst, buf_b + src, size) == buf_b + dst);
+          byte_memmove (ref_b + dst, ref_b + src, size);
+          break;
+
+        case 2:
+          ASSERT (memset (buf_b + dst, value, size) == buf_b + dst);
+          for (i = 0; i < size; i++)
+            ref_b[dst + i] = value;
+          break;
+
+        case 3:
+          memcpy (buf_b, buf_a, sizeof buf_b);
+          if (size > 0 && random_ulong () % 2)
+            buf_b[src + random_ulong () % size] ^= 1 + random_ulong () % 255;
+          ASSERT (sign (memcmp (buf_a + src, buf_b + src, size))
+                  == byte_memcmp (buf_a + src, buf_b + src, size));
+          memcpy (buf_b, ref_b, sizeof buf_b);
+          break;
+
+        case 4:
+          for (i = 0; i < size; i++)
+            if (buf_a[src + i] == '\0')
+              buf_a[src + i] = 1;
+          buf_a[src + size] = '\0';
+          ASSERT (strlen ((char *) buf_a + src) == size);
+          break;
+        }
+      ASSERT (byte_memcmp (buf_b, ref_b, sizeof buf_b) == 0);
+      if (repeat % 1000 == 0)
+        printf (" %d", repeat);
+    }
+  printf (" done\n");
+}
+
+/* Prints the bytes per 1000 cycles that the routines and their
+   byte-at-a-time counterparts move for each size and offset
+   between source and destination. */
+static void
+bench (void)
+{
+  static const size_t sizes[] = {16, 64, 256, 1024, MAX_SIZE};
+  size_t i, ofs;
+
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++)
+    for (ofs = 0; ofs < 4; ofs++)
+      {
+        size_t size = sizes[i];
+        uint64_t fast, slow, start;
+        int repeat;
+
+        start = rdtsc ();
+        for (repeat = 0; repeat < REPEAT; repeat++)
+          memcpy (buf_b + ofs, buf_a, size);
+        fast = rdtsc () - start;
+        start = rdtsc ();
+        for (repeat = 0; repeat < REPEAT; repeat++)
+          byte_memmove (buf_b + ofs, buf_a, size);
+        slow = rdtsc () - start;
+        printf ("memcpy  %4zu bytes, offset %zu: %6llu vs. %6llu "
+                "bytes per kcycle\n", size, ofs,
+                (unsigned long long) (size * REPEAT * 1000ULL / (fast + 1)),
+                (unsigned long long) (size * REPEAT * 1000ULL / (slow + 1)));
+
+        start = rdtsc ();
+        for (repeat = 0; repeat < REPEAT; repeat++)
+          memmove (buf_a + ofs, buf_a, size);
+        fast = rdtsc () - start;
+        start = rdtsc ();
+        for (repeat = 0; repeat < REPEAT; repeat++)
+          byte_memmove (buf_a + ofs, buf_a, size);
+        slow = rdtsc () - start;
+        printf ("memmove %4zu bytes, offset %zu: %6llu vs. %6llu "
+                "bytes per kcycle\n", size, ofs,
+                (unsigned long long) (size * REPEAT * 1000ULL / (fast + 1)),
+                (unsigned long long) (size * REPEAT * 1000ULL / (slow + 1)));
+
+        start = rdtsc ();
+        for (repeat = 0; repeat < REPEAT; repeat++)
+          memset (buf_b + ofs, repeat, size);
+        fast = rdtsc () - start;
+        start = rdtsc ();
+        for (repeat = 0; repeat < REPEAT; repeat++)
+          {
+            size_t j;
+            for (j = 0; j < size; j++)
+              ((volatile unsigned char *) buf_b)[ofs + j] = repeat;
+          }
+        slow = rdtsc () - start;
+        printf ("memset  %4zu bytes, offset %zu: %6llu vs. %6llu "
+                "bytes per kcycle\n", size, ofs,
+                (unsigned long long) (size * REPEAT * 1000ULL / (fast + 1)),
+                (unsigned long long) (size * REPEAT * 1000ULL / (slow + 1)));
+
+        memcpy (buf_b + ofs, buf_a, size);
+        start = rdtsc ();
+        for (repeat = 0; repeat < REPEAT; repeat++)
+          ASSERT (memcmp (buf_b + ofs, buf_a, size) == 0);
+        fast = rdtsc () - start;
+        start = rdtsc ();
+        for (repeat = 0; repeat < REPEAT; repeat++)
+          ASSERT (byte_memcmp (buf_b + ofs, buf_a, size) == 0);
+        slow = rdtsc () - start;
+        printf ("memcmp  %4zu bytes, offset %zu: %6llu vs. %6llu "
+                "bytes per kcycle\n", size, ofs,
+                (unsigned long long) (size * REPEAT * 1000ULL / (fast + 1)),
+                (unsigned long long) (size * REPEAT * 1000ULL / (slow + 1)));
+
+        memset (buf_b + ofs, 'x', size);
+        buf_b[ofs + size] = '\0';
+        start = rdtsc ();
+        for (repeat = 0; repeat < REPEAT; repeat++)
+          ASSERT (strlen ((char *) buf_b + ofs) == size);
+        fast = rdtsc () - start;
+        start = rdtsc ();
+        for (repeat = 0; repeat < REPEAT; repeat++)
+          {
+            const volatile unsigned char *p = buf_b + ofs;
+            while (*p != '\0')
+              p++;
+            ASSERT ((size_t) (p - (buf_b + ofs)) == size);
+          }
+        slow = rdtsc () - start;
+        printf ("strlen  %4zu bytes, offset %zu: %6llu vs. %6llu "
+                "bytes per kcycle\n", size, ofs,
+                (unsigned long long) (size * REPEAT * 1000ULL / (fast + 1)),
+                (unsigned long long) (size * REPEAT * 1000ULL / (slow + 1)));
+      }
+}
+
+/* Copies SIZE bytes from SRC to DST a byte at a time, correctly
+   even if they overlap. */
+static void
+byte_memmove (unsigned char *dst, const unsigned char *src, size_t size)
+{
+  volatile unsigned char *d = dst;
+  const volatile unsigned char *s = src;
+
+  if (d < s)
+    while (size-- > 0)
+      *d++ = *s++;
+  else
+    while (size-- > 0)
+      d[size] = s[size];
+}
+
+/* Compares SIZE bytes at A and B a byte at a time, returning -1,
+   0 or 1 as memcmp() might. */
+static int
+byte_memcmp (const unsigned char *a, const unsigned char *b, size_t size)
+{
+  const volatile unsigned char *x = a;
+  const volatile unsigned char *y = b;
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    if (x[i] != y[i])
+      return x[i] > y[i] ? 1 : -1;
+  return 0;
+}
+
+/* Returns the sign of X: -1, 0 or 1. */
+static int
+sign (int x)
+{
+  return x < 0 ? -1 : x > 0;
+}
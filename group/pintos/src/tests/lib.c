@@ -76,6 +76,16 @@ shuffle (void *buf_, size_t cnt, size_t size)
     }
 }
 
+/* Returns the time stamp counter, for timing benchmarks in
+   CPU cycles. */
+uint64_t
+rdtsc (void)
+{
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
 void
 exec_children (const char *child_name, pid_t pids[], size_t child_cnt)
 {
@@ -0,0 +1,118 @@
+/* Puts a few thousand threads to sleep at once and checks that
+   the timer interrupt does not get slower because of them: a
+   busy loop must get about as many iterations done per tick
+   with all of them asleep as with none.  Then checks that every
+   sleeper wakes up, and none of them early. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SLEEPER_CNT 2000        /* Number of sleeping threads. */
+#define SAMPLE_TICKS 10         /* Ticks to average loop counts over. */
+
+static thread_func sleeper;
+static int64_t loops_per_tick (void);
+
+static struct semaphore go_sema;
+static int64_t start;
+static int sleeping_cnt;
+static int woken_cnt;
+static int early_cnt;
+
+void
+test_alarm_many (void)
+{
+  int64_t idle_loops, busy_loops;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  msg ("Measuring timer tick cost with no sleepers.");
+  idle_loops = loops_per_tick ();
+
+  msg ("Creating %d threads.", SLEEPER_CNT);
+  sema_init (&go_sema, 0);
+  for (i = 0; i < SLEEPER_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "sleeper %d", i);
+      if (thread_create (name, PRI_DEFAULT, sleeper, (void *) i) == TID_ERROR)
+        fail ("creating thread %d failed", i);
+    }
+
+  /* Release the sleepers only now, so that the time it takes to
+     create them does not eat into their deadlines. */
+  msg ("Putting %d threads to sleep.", SLEEPER_CNT);
+  start = timer_ticks ();
+  for (i = 0; i < SLEEPER_CNT; i++)
+    sema_up (&go_sema);
+  while (sleeping_cnt < SLEEPER_CNT)
+    timer_sleep (1);
+  timer_sleep (1);
+
+  msg ("Measuring timer tick cost with %d sleepers.", SLEEPER_CNT);
+  busy_loops = loops_per_tick ();
+  if (busy_loops < idle_loops * 3 / 4)
+    fail ("%lld loops per tick with sleepers, %lld without",
+          busy_loops, idle_loops);
+  msg ("Tick cost did not grow with the number of sleepers.");
+
+  /* Wait for everyone to wake up. */
+  timer_sleep (start + 200 - timer_ticks ());
+  while (woken_cnt < SLEEPER_CNT)
+    timer_sleep (1);
+  if (early_cnt != 0)
+    fail ("%d threads woke up before their deadline", early_cnt);
+  msg ("All %d sleepers woke up on time.", SLEEPER_CNT);
+}
+
+/* Sleeper thread.  Sleeps until a deadline between 100 and 199
+   ticks after START, spread out so the sleepers do not go to
+   sleep in deadline order. */
+static void
+sleeper (void *aux)
+{
+  int i = (int) aux;
+  int64_t deadline;
+  enum intr_level old_level;
+
+  sema_down (&go_sema);
+  deadline = start + 100 + i * 37 % 100;
+
+  old_level = intr_disable ();
+  sleeping_cnt++;
+  intr_set_level (old_level);
+
+  timer_sleep (deadline - timer_ticks ());
+
+  old_level = intr_disable ();
+  if (timer_ticks () < deadline)
+    early_cnt++;
+  woken_cnt++;
+  intr_set_level (old_level);
+}
+
+/* Returns the number of iterations of a busy loop that complete
+   per timer tick, averaged over SAMPLE_TICKS ticks. */
+static int64_t
+loops_per_tick (void)
+{
+  int64_t loops = 0;
+  int64_t then;
+
+  /* Start at the beginning of a tick. */
+  then = timer_ticks ();
+  while (timer_ticks () == then)
+    continue;
+
+  then = timer_ticks ();
+  while (timer_elapsed (then) < SAMPLE_TICKS)
+    loops++;
+  return loops / SAMPLE_TICKS;
+}
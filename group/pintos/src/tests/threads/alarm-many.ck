@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-many) begin
+(alarm-many) Measuring timer tick cost with no sleepers.
+(alarm-many) Creating 2000 threads.
+(alarm-many) Putting 2000 threads to sleep.
+(alarm-many) Measuring timer tick cost with 2000 sleepers.
+(alarm-many) Tick cost did not grow with the number of sleepers.
+(alarm-many) All 2000 sleepers woke up on time.
+(alarm-many) end
+EOF
+pass;
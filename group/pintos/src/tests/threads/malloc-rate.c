@@ -0,0 +1,102 @@
+/* Measures how many malloc()/free() pairs per second several
+   threads can do between them, first with malloc_magazines
+   turned off, so that every call takes its size's lock, and then
+   with it turned on.  The threads run at the same priority, so
+   timer interrupts preempt them in the middle of malloc() and
+   free().  The rates vary from run to run, so only their
+   presence is checked. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 8            /* Number of threads. */
+#define BLOCK_CNT 16            /* Blocks each thread holds at once. */
+#define SAMPLE_TICKS 50         /* Ticks to allocate for. */
+
+static thread_func malloc_thread;
+static long long malloc_rate (void);
+
+static struct semaphore done;
+static int64_t start_tick;
+static long long pair_cnts[THREAD_CNT];
+
+void
+test_malloc_rate (void)
+{
+  bool magazines = malloc_magazines;
+
+  sema_init (&done, 0);
+
+  msg ("Running %d threads without magazines.", THREAD_CNT);
+  malloc_magazines = false;
+  msg ("%lld malloc/free pairs per second.", malloc_rate ());
+
+  msg ("Running %d threads with magazines.", THREAD_CNT);
+  malloc_magazines = true;
+  msg ("%lld malloc/free pairs per second.", malloc_rate ());
+
+  malloc_magazines = magazines;
+}
+
+/* Runs THREAD_CNT threads that allocate and free blocks for
+   SAMPLE_TICKS timer ticks and returns the number of pairs they
+   completed per second. */
+static long long
+malloc_rate (void)
+{
+  long long cnt = 0;
+  int i;
+
+  /* Start at a tick boundary.  Our priority is higher than the
+     threads', so they don't start until we wait for them. */
+  start_tick = timer_ticks ();
+  while (timer_ticks () == start_tick)
+    continue;
+  start_tick = timer_ticks ();
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+      snprintf (name, sizeof name, "malloc %d", i);
+      thread_create (name, PRI_DEFAULT - 1, malloc_thread, &pair_cnts[i]);
+    }
+  for (i = 0; i < THREAD_CNT; i++)
+    sema_down (&done);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    cnt += pair_cnts[i];
+  return cnt * TIMER_FREQ / SAMPLE_TICKS;
+}
+
+static void
+malloc_thread (void *cnt_)
+{
+  long long *cnt = cnt_;
+  void *blocks[BLOCK_CNT];
+  unsigned seed = (unsigned) cnt;
+
+  *cnt = 0;
+  while (timer_elapsed (start_tick) < SAMPLE_TICKS)
+    {
+      int i;
+
+      for (i = 0; i < BLOCK_CNT; i++)
+        {
+          /* Sizes from 1 to 512 bytes, spread over the small
+             size classes. */
+          seed = seed * 1103515245 + 12345;
+          blocks[i] = malloc ((seed >> 16) % 512 + 1);
+          if (blocks[i] == NULL)
+            fail ("malloc failed");
+        }
+      for (i = 0; i < BLOCK_CNT; i++)
+        free (blocks[i]);
+      *cnt += BLOCK_CNT;
+    }
+  sema_up (&done);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+s/^\(malloc-rate\) \d+ malloc\/free pairs per second\.$/(malloc-rate) N malloc\/free pairs per second./
+  foreach @output;
+compare_output ("run", \@output, [<<'EOF']);
+(malloc-rate) begin
+(malloc-rate) Running 8 threads without magazines.
+(malloc-rate) N malloc/free pairs per second.
+(malloc-rate) Running 8 threads with magazines.
+(malloc-rate) N malloc/free pairs per second.
+(malloc-rate) end
+EOF
+pass;
@@ -0,0 +1,76 @@
+/* Checks that a semaphore wakes its waiters in the order of
+   their current priorities, even when those priorities have
+   changed while the waiters were blocked.
+
+   A thread with nice 10 blocks on a semaphore right away, at
+   priority 43.  A thread with nice 0 spins for 10 seconds, which
+   drives its recent_cpu up and its priority down to about 30,
+   and then blocks on the same semaphore.  While both wait for 10
+   more seconds, recent_cpu decays, bringing the nice 0 thread
+   back to priority 63, while the nice 10 thread stays around 40.
+   So the nice 0 thread must be woken first. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+static thread_func spin_thread, nice_thread;
+
+void
+test_mlfqs_block_order (void)
+{
+  struct semaphore sema;
+
+  ASSERT (thread_mlfqs);
+
+  sema_init (&sema, 0);
+
+  msg ("Creating a thread with nice 10, which blocks at once.");
+  thread_create ("nice", PRI_DEFAULT, nice_thread, &sema);
+  timer_sleep (TIMER_FREQ);
+
+  msg ("Creating a thread with nice 0, which spins, then blocks.");
+  thread_create ("spin", PRI_DEFAULT, spin_thread, &sema);
+  timer_sleep (11 * TIMER_FREQ);
+
+  msg ("Sleeping 10 seconds while both are blocked...");
+  timer_sleep (10 * TIMER_FREQ);
+
+  msg ("Waking one thread.");
+  sema_up (&sema);
+  timer_sleep (TIMER_FREQ);
+
+  msg ("Waking the other thread.");
+  sema_up (&sema);
+  timer_sleep (TIMER_FREQ);
+}
+
+static void
+nice_thread (void *sema_)
+{
+  struct semaphore *sema = sema_;
+
+  thread_set_nice (10);
+  msg ("Thread with nice 10 blocking.");
+  sema_down (sema);
+  msg ("Thread with nice 10 woke up.");
+}
+
+static void
+spin_thread (void *sema_)
+{
+  struct semaphore *sema = sema_;
+  int64_t start_time;
+
+  msg ("Thread with nice 0 spinning for 10 seconds...");
+  start_time = timer_ticks ();
+  while (timer_elapsed (start_time) < 10 * TIMER_FREQ)
+    continue;
+
+  msg ("Thread with nice 0 blocking.");
+  sema_down (sema);
+  msg ("Thread with nice 0 woke up.");
+}
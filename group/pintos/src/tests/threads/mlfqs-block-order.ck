@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(mlfqs-block-order) begin
+(mlfqs-block-order) Creating a thread with nice 10, which blocks at once.
+(mlfqs-block-order) Thread with nice 10 blocking.
+(mlfqs-block-order) Creating a thread with nice 0, which spins, then blocks.
+(mlfqs-block-order) Thread with nice 0 spinning for 10 seconds...
+(mlfqs-block-order) Thread with nice 0 blocking.
+(mlfqs-block-order) Sleeping 10 seconds while both are blocked...
+(mlfqs-block-order) Waking one thread.
+(mlfqs-block-order) Thread with nice 0 woke up.
+(mlfqs-block-order) Waking the other thread.
+(mlfqs-block-order) Thread with nice 10 woke up.
+(mlfqs-block-order) end
+EOF
+pass;
@@ -0,0 +1,76 @@
+/* The main thread holds a readers-writer lock for reading, and a
+   high-priority writer waits for it, donating its priority to
+   the main thread.  A medium-priority thread must not run until
+   the writer is done.  Then the main thread holds the lock for
+   writing, and a high-priority reader waits for it, again
+   donating its priority to the main thread. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+static thread_func medium_thread_func;
+
+void
+test_priority_donate_rwlock (void)
+{
+  struct rwlock rwlock;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rwlock);
+
+  rwlock_acquire_read (&rwlock);
+  thread_create ("writer", PRI_DEFAULT + 10, writer_thread_func, &rwlock);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 10, thread_get_priority ());
+  thread_create ("medium", PRI_DEFAULT + 5, medium_thread_func, NULL);
+  msg ("Main thread releasing read lock.");
+  rwlock_release_read (&rwlock);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+
+  rwlock_acquire_write (&rwlock);
+  thread_create ("reader", PRI_DEFAULT + 10, reader_thread_func, &rwlock);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 10, thread_get_priority ());
+  rwlock_release_write (&rwlock);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+reader_thread_func (void *rwlock_)
+{
+  struct rwlock *rwlock = rwlock_;
+
+  rwlock_acquire_read (rwlock);
+  msg ("reader: got the read lock");
+  rwlock_release_read (rwlock);
+  msg ("reader: done");
+}
+
+static void
+writer_thread_func (void *rwlock_)
+{
+  struct rwlock *rwlock = rwlock_;
+
+  rwlock_acquire_write (rwlock);
+  msg ("writer: got the write lock");
+  rwlock_release_write (rwlock);
+  msg ("writer: done");
+}
+
+static void
+medium_thread_func (void *aux UNUSED)
+{
+  msg ("medium: running");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(priority-donate-rwlock) begin
+(priority-donate-rwlock) Main thread should have priority 41.  Actual priority: 41.
+(priority-donate-rwlock) Main thread releasing read lock.
+(priority-donate-rwlock) writer: got the write lock
+(priority-donate-rwlock) writer: done
+(priority-donate-rwlock) medium: running
+(priority-donate-rwlock) Main thread should have priority 31.  Actual priority: 31.
+(priority-donate-rwlock) Main thread should have priority 41.  Actual priority: 41.
+(priority-donate-rwlock) reader: got the read lock
+(priority-donate-rwlock) reader: done
+(priority-donate-rwlock) Main thread should have priority 31.  Actual priority: 31.
+(priority-donate-rwlock) end
+EOF
+pass;
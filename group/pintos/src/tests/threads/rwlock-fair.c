@@ -0,0 +1,67 @@
+/* The main thread holds a readers-writer lock for reading while
+   another reader comes and goes, showing that readers share the
+   lock.  Then a writer arrives and waits for the main thread,
+   followed by two readers and a writer that line up behind it.
+   Once the main thread releases the lock, they should be served
+   in the order they arrived, without the second reader slipping
+   in ahead of the first writer. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader_thread_func;
+static thread_func writer_thread_func;
+
+void
+test_rwlock_fair (void)
+{
+  struct rwlock rwlock;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rwlock);
+  rwlock_acquire_read (&rwlock);
+  thread_create ("reader 0", PRI_DEFAULT + 1, reader_thread_func, &rwlock);
+  thread_create ("writer 1", PRI_DEFAULT + 1, writer_thread_func, &rwlock);
+
+  /* Now the writer has donated its priority to us, so let each of
+     these threads run until it blocks. */
+  thread_create ("reader 2", PRI_DEFAULT + 1, reader_thread_func, &rwlock);
+  thread_yield ();
+  thread_create ("writer 2", PRI_DEFAULT + 1, writer_thread_func, &rwlock);
+  thread_yield ();
+  thread_create ("reader 3", PRI_DEFAULT + 1, reader_thread_func, &rwlock);
+  thread_yield ();
+
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 1, thread_get_priority ());
+  rwlock_release_read (&rwlock);
+  msg ("Main thread done.");
+}
+
+static void
+reader_thread_func (void *rwlock_)
+{
+  struct rwlock *rwlock = rwlock_;
+
+  rwlock_acquire_read (rwlock);
+  msg ("%s reading.", thread_name ());
+  rwlock_release_read (rwlock);
+}
+
+static void
+writer_thread_func (void *rwlock_)
+{
+  struct rwlock *rwlock = rwlock_;
+
+  rwlock_acquire_write (rwlock);
+  msg ("%s writing.", thread_name ());
+  rwlock_release_write (rwlock);
+}
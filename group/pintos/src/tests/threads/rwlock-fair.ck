@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock-fair) begin
+(rwlock-fair) reader 0 reading.
+(rwlock-fair) Main thread should have priority 32.  Actual priority: 32.
+(rwlock-fair) writer 1 writing.
+(rwlock-fair) reader 2 reading.
+(rwlock-fair) writer 2 writing.
+(rwlock-fair) reader 3 reading.
+(rwlock-fair) Main thread done.
+(rwlock-fair) end
+EOF
+pass;
@@ -0,0 +1,105 @@
+/* Checks the scheduler statistics returned by
+   thread_get_sched_stats() and kept in struct thread.  The main
+   thread wakes a higher-priority thread PING_PONGS times; each
+   time, the woken thread preempts the main thread and then
+   blocks again.  That should be counted as exactly one wake-up,
+   one involuntary switch of the main thread and one voluntary
+   switch of the other thread per round, plus one wake-up and one
+   preemption for creating the thread. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define PING_PONGS 100
+
+struct pong_info
+  {
+    struct semaphore ping;      /* Upped by the main thread. */
+    struct semaphore pong;      /* Upped by the pong thread. */
+    unsigned wake_ups;          /* Pong thread's wake-ups. */
+    unsigned voluntary;         /* Pong thread's voluntary switches. */
+  };
+
+static thread_func pong_thread_func;
+
+void
+test_sched_stats (void)
+{
+  struct pong_info info;
+  struct sched_stats before, after;
+  struct thread *cur = thread_current ();
+  unsigned involuntary;
+  enum intr_level old_level;
+  int i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  sema_init (&info.ping, 0);
+  sema_init (&info.pong, 0);
+
+  /* Let a couple of timer ticks sample the run queue. */
+  thread_get_sched_stats (&before);
+  timer_sleep (2);
+
+  old_level = intr_disable ();
+  involuntary = cur->involuntary_switches;
+  intr_set_level (old_level);
+
+  thread_create ("pong", PRI_DEFAULT + 1, pong_thread_func, &info);
+  for (i = 0; i < PING_PONGS; i++)
+    {
+      sema_up (&info.ping);
+      sema_down (&info.pong);
+    }
+
+  old_level = intr_disable ();
+  involuntary = cur->involuntary_switches - involuntary;
+  intr_set_level (old_level);
+  thread_get_sched_stats (&after);
+
+  msg ("pong was woken %u times (%d expected).",
+       info.wake_ups, PING_PONGS + 1);
+  msg ("pong blocked %u times (%d expected).",
+       info.voluntary, PING_PONGS);
+  msg ("main was preempted %u times (%d expected).",
+       involuntary, PING_PONGS + 1);
+
+  if (after.wake_latency.samples - before.wake_latency.samples
+      < PING_PONGS)
+    fail ("too few wake-up latency samples");
+  if (after.voluntary - before.voluntary < PING_PONGS)
+    fail ("too few voluntary context switches");
+  if (after.involuntary - before.involuntary < PING_PONGS)
+    fail ("too few involuntary context switches");
+  if (after.rq_samples <= before.rq_samples)
+    fail ("run queue length was not sampled");
+  msg ("System-wide statistics are consistent.");
+}
+
+static void
+pong_thread_func (void *info_)
+{
+  struct pong_info *info = info_;
+  struct thread *cur = thread_current ();
+  enum intr_level old_level;
+  int i;
+
+  for (i = 0; i < PING_PONGS; i++)
+    {
+      sema_down (&info->ping);
+      if (i == PING_PONGS - 1)
+        {
+          old_level = intr_disable ();
+          info->wake_ups = cur->wake_latency.samples;
+          info->voluntary = cur->voluntary_switches;
+          intr_set_level (old_level);
+        }
+      sema_up (&info->pong);
+    }
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sched-stats) begin
+(sched-stats) pong was woken 101 times (101 expected).
+(sched-stats) pong blocked 100 times (100 expected).
+(sched-stats) main was preempted 101 times (101 expected).
+(sched-stats) System-wide statistics are consistent.
+(sched-stats) end
+EOF
+pass;
@@ -0,0 +1,68 @@
+/* Measures how many short-lived kernel threads can be created
+   and joined per second, first with thread_cache_pages turned
+   off, so that every thread gets a fresh page from the page
+   allocator, and then with it turned on.  The rates vary from
+   run to run, so only their presence is checked. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define SAMPLE_TICKS 50         /* Ticks to spawn threads for. */
+
+static thread_func worker;
+static long long spawn_rate (void);
+
+static struct semaphore done;
+
+void
+test_spawn_rate (void)
+{
+  bool cache_pages = thread_cache_pages;
+
+  sema_init (&done, 0);
+
+  msg ("Spawning threads without the thread page cache.");
+  thread_cache_pages = false;
+  msg ("%lld threads per second.", spawn_rate ());
+
+  msg ("Spawning threads with the thread page cache.");
+  thread_cache_pages = true;
+  msg ("%lld threads per second.", spawn_rate ());
+
+  thread_cache_pages = cache_pages;
+}
+
+/* Creates and waits for one thread after another for
+   SAMPLE_TICKS timer ticks and returns the number created per
+   second. */
+static long long
+spawn_rate (void)
+{
+  long long cnt = 0;
+  int64_t start;
+
+  /* Start at a tick boundary. */
+  start = timer_ticks ();
+  while (timer_ticks () == start)
+    continue;
+
+  start = timer_ticks ();
+  while (timer_elapsed (start) < SAMPLE_TICKS)
+    {
+      if (thread_create ("worker", PRI_DEFAULT, worker, NULL) == TID_ERROR)
+        fail ("thread_create failed after %lld threads", cnt);
+      sema_down (&done);
+      cnt++;
+    }
+  return cnt * TIMER_FREQ / timer_elapsed (start);
+}
+
+static void
+worker (void *aux UNUSED)
+{
+  sema_up (&done);
+}
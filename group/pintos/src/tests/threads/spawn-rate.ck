@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+s/^\(spawn-rate\) \d+ threads per second\.$/(spawn-rate) N threads per second./
+  foreach @output;
+compare_output ("run", \@output, [<<'EOF']);
+(spawn-rate) begin
+(spawn-rate) Spawning threads without the thread page cache.
+(spawn-rate) N threads per second.
+(spawn-rate) Spawning threads with the thread page cache.
+(spawn-rate) N threads per second.
+(spawn-rate) end
+EOF
+pass;
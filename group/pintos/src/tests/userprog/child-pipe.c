@@ -0,0 +1,53 @@
+/* Child process run by pipe-exec and pipe-exec-early tests.
+
+   Without arguments, writes CHILD_PIPE_SIZE bytes of a known
+   pattern to its standard output, which the parent has
+   connected to a pipe, in a single write() call, and exits with
+   code 1 if fewer were written.
+
+   With argument "read", reads the first CHILD_PIPE_READ_SIZE
+   bytes of that pattern from its standard input and exits
+   without reading the rest, with code 2 if the data is wrong. */
+
+#include <stdio.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/child-pipe.h"
+#include "tests/lib.h"
+
+const char *test_name = "child-pipe";
+
+static char buf[CHILD_PIPE_SIZE];
+
+/* Reads the start of the pattern from standard input. */
+static int
+read_pattern (void)
+{
+  int ofs, n, i;
+
+  for (ofs = 0; ofs < CHILD_PIPE_READ_SIZE; ofs += n)
+    {
+      n = read (STDIN_FILENO, buf + ofs, CHILD_PIPE_READ_SIZE - ofs);
+      if (n <= 0)
+        return 2;
+    }
+  for (i = 0; i < CHILD_PIPE_READ_SIZE; i++)
+    if (buf[i] != CHILD_PIPE_BYTE (i))
+      return 2;
+  return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int i;
+
+  if (argc > 1 && !strcmp (argv[1], "read"))
+    return read_pattern ();
+
+  for (i = 0; i < CHILD_PIPE_SIZE; i++)
+    buf[i] = CHILD_PIPE_BYTE (i);
+  if (write (STDOUT_FILENO, buf, sizeof buf) != sizeof buf)
+    return 1;
+  return 0;
+}
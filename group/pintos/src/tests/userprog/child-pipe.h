@@ -0,0 +1,13 @@
+#ifndef TESTS_USERPROG_CHILD_PIPE_H
+#define TESTS_USERPROG_CHILD_PIPE_H
+
+/* Bytes that child-pipe writes, several pipes' worth. */
+#define CHILD_PIPE_SIZE 20000
+
+/* Bytes that "child-pipe read" reads before it exits. */
+#define CHILD_PIPE_READ_SIZE 100
+
+/* Byte I of what it writes. */
+#define CHILD_PIPE_BYTE(I) ((char) ((I) % 251))
+
+#endif /* tests/userprog/child-pipe.h */
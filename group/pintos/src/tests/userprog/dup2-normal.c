@@ -0,0 +1,33 @@
+/* Duplicates a file descriptor with dup2() and checks that the
+   copy shares the original's file position and outlives it. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char buf[10];
+  int fd;
+
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (dup2 (fd, 20) == 20, "dup2 to descriptor 20");
+  CHECK (dup2 (20, 20) == 20, "dup2 descriptor 20 onto itself");
+
+  CHECK (read (fd, buf, sizeof buf) == sizeof buf, "read original");
+  compare_bytes (buf, sample, sizeof buf, 0, "sample.txt");
+  CHECK (read (20, buf, sizeof buf) == sizeof buf, "read copy");
+  compare_bytes (buf, sample + 10, sizeof buf, 10, "sample.txt");
+
+  close (fd);
+  CHECK (read (20, buf, sizeof buf) == sizeof buf,
+         "read copy after closing original");
+  compare_bytes (buf, sample + 20, sizeof buf, 20, "sample.txt");
+  CHECK (tell (20) == 30, "tell copy");
+
+  CHECK (dup2 (fd, 21) == -1, "dup2 from closed descriptor");
+  CHECK (dup2 (20, -1) == -1, "dup2 to negative descriptor");
+  close (20);
+}
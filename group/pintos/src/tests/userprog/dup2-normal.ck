@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(dup2-normal) begin
+(dup2-normal) open "sample.txt"
+(dup2-normal) dup2 to descriptor 20
+(dup2-normal) dup2 descriptor 20 onto itself
+(dup2-normal) read original
+(dup2-normal) read copy
+(dup2-normal) read copy after closing original
+(dup2-normal) tell copy
+(dup2-normal) dup2 from closed descriptor
+(dup2-normal) dup2 to negative descriptor
+(dup2-normal) end
+dup2-normal: exit(0)
+EOF
+pass;
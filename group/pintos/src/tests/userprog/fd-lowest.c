@@ -0,0 +1,33 @@
+/* Opens enough files to make the descriptor table grow several
+   times, checking that each open returns the lowest free
+   descriptor, including after closing some in the middle. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Files to open at once, more than fit in a new table. */
+#define FILE_CNT 200
+
+void
+test_main (void)
+{
+  int i, fd;
+
+  for (i = 0; i < FILE_CNT; i++)
+    if ((fd = open ("sample.txt")) != i + 3)
+      fail ("open #%d returned %d instead of %d", i, fd, i + 3);
+  msg ("opened \"sample.txt\" %d times", FILE_CNT);
+
+  close (150);
+  close (10);
+  close (40);
+  CHECK ((fd = open ("sample.txt")) == 10, "open returned %d", fd);
+  CHECK ((fd = open ("sample.txt")) == 40, "open returned %d", fd);
+  CHECK ((fd = open ("sample.txt")) == 150, "open returned %d", fd);
+  CHECK ((fd = open ("sample.txt")) == FILE_CNT + 3, "open returned %d", fd);
+
+  CHECK (dup2 (3, 900) == 900, "dup2 to descriptor 900");
+  CHECK (dup2 (3, 100000) == -1, "dup2 to descriptor 100000");
+  CHECK ((fd = open ("sample.txt")) == FILE_CNT + 4, "open returned %d", fd);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(fd-lowest) begin
+(fd-lowest) opened "sample.txt" 200 times
+(fd-lowest) open returned 10
+(fd-lowest) open returned 40
+(fd-lowest) open returned 150
+(fd-lowest) open returned 203
+(fd-lowest) dup2 to descriptor 900
+(fd-lowest) dup2 to descriptor 100000
+(fd-lowest) open returned 204
+(fd-lowest) end
+fd-lowest: exit(0)
+EOF
+pass;
@@ -0,0 +1,46 @@
+/* Connects two child-pipe processes through a pipe, a writer
+   that writes more than the pipe holds and a reader that exits
+   after reading a little of it.  The writer must see its write
+   fall short, instead of blocking forever, once the reader is
+   gone.
+
+   The writer is started while we still hold the pipe's read
+   end, as a shell running a pipeline from left to right would.
+   Only descriptors 0 through 2 are inherited, so the writer
+   does not get a read end of its own pipe that would keep it
+   blocked. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  pid_t writer, reader;
+  int writer_status, reader_status;
+  int fds[2];
+
+  CHECK (pipe (fds), "pipe");
+
+  /* Start both children before printing anything else, since
+     they print their exit codes whenever they finish. */
+  dup2 (STDIN_FILENO, 10);
+  dup2 (STDOUT_FILENO, 11);
+  dup2 (fds[1], STDOUT_FILENO);
+  close (fds[1]);
+  writer = exec ("child-pipe");
+  dup2 (11, STDOUT_FILENO);
+  dup2 (fds[0], STDIN_FILENO);
+  close (fds[0]);
+  reader = exec ("child-pipe read");
+  dup2 (10, STDIN_FILENO);
+  close (10);
+  close (11);
+
+  reader_status = wait (reader);
+  writer_status = wait (writer);
+  CHECK (reader_status == 0, "reader read the start of the data");
+  CHECK (writer_status == 1, "writer's write fell short");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-exec-early) begin
+(pipe-exec-early) pipe
+child-pipe: exit(0)
+child-pipe: exit(1)
+(pipe-exec-early) reader read the start of the data
+(pipe-exec-early) writer's write fell short
+(pipe-exec-early) end
+pipe-exec-early: exit(0)
+EOF
+pass;
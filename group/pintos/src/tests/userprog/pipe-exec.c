@@ -0,0 +1,50 @@
+/* Runs child-pipe with its standard output redirected into a
+   pipe, and reads what it writes from the other end until end of
+   file.  The child writes more than a pipe holds, so both sides
+   have to block and wake each other up. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/userprog/child-pipe.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  static char buf[512];
+  size_t total = 0;
+  int fds[2];
+  pid_t pid;
+  int n;
+
+  CHECK (pipe (fds), "pipe");
+
+  /* Hand the write end to the child as its standard output, and
+     keep no write end of our own, so that we see end of file
+     when the child exits. */
+  CHECK (dup2 (STDOUT_FILENO, 10) == 10, "save standard output");
+  dup2 (fds[1], STDOUT_FILENO);
+  close (fds[1]);
+  pid = exec ("child-pipe");
+  dup2 (10, STDOUT_FILENO);
+  close (10);
+  CHECK (pid != PID_ERROR, "exec child-pipe");
+
+  while ((n = read (fds[0], buf, sizeof buf)) > 0)
+    {
+      int i;
+
+      for (i = 0; i < n; i++)
+        if (buf[i] != CHILD_PIPE_BYTE (total + i))
+          fail ("byte %zu differs from what child-pipe wrote", total + i);
+      total += n;
+    }
+  CHECK (n == 0, "read to end of file");
+  if (total != CHILD_PIPE_SIZE)
+    fail ("read %zu bytes instead of %d", total, CHILD_PIPE_SIZE);
+  msg ("verified %d bytes", CHILD_PIPE_SIZE);
+  close (fds[0]);
+
+  CHECK (wait (pid) == 0, "wait for child-pipe");
+}
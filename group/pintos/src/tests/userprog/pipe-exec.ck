@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-exec) begin
+(pipe-exec) pipe
+(pipe-exec) save standard output
+(pipe-exec) exec child-pipe
+child-pipe: exit(0)
+(pipe-exec) read to end of file
+(pipe-exec) verified 20000 bytes
+(pipe-exec) wait for child-pipe
+(pipe-exec) end
+pipe-exec: exit(0)
+EOF
+pass;
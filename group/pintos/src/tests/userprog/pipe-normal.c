@@ -0,0 +1,36 @@
+/* Writes to a pipe and reads the data back, then checks that the
+   read end sees end of file once the write end is closed, and
+   that writing fails once the read end is. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  static const char data[] = "Through the pipe and back again.";
+  char buf[sizeof data];
+  int fds[2];
+
+  CHECK (pipe (fds), "pipe");
+  CHECK (fds[0] > 1 && fds[1] > 1 && fds[0] != fds[1],
+         "got two new descriptors");
+
+  CHECK (write (fds[1], data, 8) == 8, "write 8 bytes");
+  CHECK (write (fds[1], data + 8, sizeof data - 8) == sizeof data - 8,
+         "write the rest");
+  CHECK (read (fds[0], buf, sizeof buf) == sizeof buf, "read it all back");
+  if (memcmp (buf, data, sizeof data))
+    fail ("data read back differs from data written");
+
+  close (fds[1]);
+  CHECK (read (fds[0], buf, sizeof buf) == 0, "read at end of file");
+  close (fds[0]);
+
+  CHECK (pipe (fds), "pipe");
+  close (fds[0]);
+  CHECK (write (fds[1], data, sizeof data) == -1, "write with no reader");
+  close (fds[1]);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-normal) begin
+(pipe-normal) pipe
+(pipe-normal) got two new descriptors
+(pipe-normal) write 8 bytes
+(pipe-normal) write the rest
+(pipe-normal) read it all back
+(pipe-normal) read at end of file
+(pipe-normal) pipe
+(pipe-normal) write with no reader
+(pipe-normal) end
+pipe-normal: exit(0)
+EOF
+pass;
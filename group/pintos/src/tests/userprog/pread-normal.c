@@ -0,0 +1,35 @@
+/* Reads parts of a file with pread() and checks that they come
+   from the requested offsets and that the file position does not
+   move. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  char buf[32];
+  int handle, byte_cnt;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  byte_cnt = pread (handle, buf, sizeof buf, 40);
+  if (byte_cnt != sizeof buf)
+    fail ("pread() returned %d instead of %zu", byte_cnt, sizeof buf);
+  compare_bytes (buf, sample + 40, sizeof buf, 40, "sample.txt");
+
+  byte_cnt = pread (handle, buf, sizeof buf, 0);
+  if (byte_cnt != sizeof buf)
+    fail ("pread() returned %d instead of %zu", byte_cnt, sizeof buf);
+  compare_bytes (buf, sample, sizeof buf, 0, "sample.txt");
+
+  byte_cnt = pread (handle, buf, sizeof buf, sizeof sample - 11);
+  if (byte_cnt != 10)
+    fail ("pread() near end of file returned %d instead of 10", byte_cnt);
+
+  if (tell (handle) != 0)
+    fail ("pread() moved file position to %u", tell (handle));
+  msg ("pread \"sample.txt\"");
+}
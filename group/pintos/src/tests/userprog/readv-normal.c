@@ -0,0 +1,37 @@
+/* Reads a file into three buffers with one readv() call, the
+   last of them bigger than what is left of the file. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  static char head[10], middle[100], tail[200];
+  struct iovec iov[3] =
+    {
+      {head, sizeof head},
+      {middle, sizeof middle},
+      {tail, sizeof tail},
+    };
+  size_t size = sizeof sample - 1;
+  size_t tail_size = size - sizeof head - sizeof middle;
+  int handle, byte_cnt;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  byte_cnt = readv (handle, iov, 3);
+  if (byte_cnt != (int) size)
+    fail ("readv() returned %d instead of %zu", byte_cnt, size);
+  compare_bytes (head, sample, sizeof head, 0, "sample.txt");
+  compare_bytes (middle, sample + sizeof head, sizeof middle,
+                 sizeof head, "sample.txt");
+  compare_bytes (tail, sample + sizeof head + sizeof middle, tail_size,
+                 sizeof head + sizeof middle, "sample.txt");
+
+  if (tell (handle) != size)
+    fail ("readv() left file position at %u", tell (handle));
+  msg ("readv \"sample.txt\"");
+}
@@ -0,0 +1,51 @@
+/* Opens, seeks in, reads and closes a file through the system
+   call rings, and checks every result. */
+
+#include <ring.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Reaps the next completion and checks that it carries
+   USER_DATA, then returns its result. */
+static int
+reap (uint32_t user_data)
+{
+  struct ring_cqe cqe;
+
+  if (!ring_reap (&cqe))
+    fail ("no completion for call %u", user_data);
+  if (cqe.user_data != user_data)
+    fail ("completion for call %u instead of %u", cqe.user_data, user_data);
+  return cqe.result;
+}
+
+void
+test_main (void)
+{
+  char head[20], tail[20];
+  int fd;
+
+  CHECK (ring_init (), "ring_init");
+
+  ring_open ("sample.txt", 1);
+  CHECK (ring_submit () == 1, "submit open");
+  CHECK ((fd = reap (1)) > 1, "open \"sample.txt\"");
+
+  ring_seek (fd, 10, 2);
+  ring_read (fd, head, sizeof head, 3);
+  ring_read (fd, tail, sizeof tail, 4);
+  ring_close (fd, 5);
+  CHECK (ring_submit () == 4, "submit seek, read, read, close");
+
+  if (reap (2) != 0)
+    fail ("seek failed");
+  if (reap (3) != sizeof head || reap (4) != sizeof tail)
+    fail ("read returned wrong count");
+  if (reap (5) != 0)
+    fail ("close failed");
+  compare_bytes (head, sample + 10, sizeof head, 10, "sample.txt");
+  compare_bytes (tail, sample + 30, sizeof tail, 30, "sample.txt");
+  msg ("verified results");
+}
@@ -0,0 +1,75 @@
+/* Writes a file in small pieces, first with one write() system
+   call per piece and then in batches through the system call
+   rings, and reports the cost per write of each. */
+
+#include <ring.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Bytes per write. */
+#define PIECE_SIZE 64
+
+/* Writes per run. */
+#define PIECE_CNT 1024
+
+static char piece[PIECE_SIZE];
+
+/* Writes the file one system call per piece. */
+static void
+write_plain (int fd)
+{
+  int i;
+
+  seek (fd, 0);
+  for (i = 0; i < PIECE_CNT; i++)
+    if (write (fd, piece, PIECE_SIZE) != PIECE_SIZE)
+      fail ("write %d failed", i);
+}
+
+/* Writes the file through the rings, as many pieces per
+   ring_submit() as fit. */
+static void
+write_ring (int fd)
+{
+  int queued = 0, reaped = 0;
+  struct ring_cqe cqe;
+
+  seek (fd, 0);
+  while (reaped < PIECE_CNT)
+    {
+      while (queued < PIECE_CNT && ring_write (fd, piece, PIECE_SIZE, queued))
+        queued++;
+      ring_submit ();
+      while (ring_reap (&cqe))
+        {
+          if (cqe.result != PIECE_SIZE)
+            fail ("write %u failed", cqe.user_data);
+          reaped++;
+        }
+    }
+}
+
+void
+test_main (void)
+{
+  uint64_t start;
+  int fd;
+
+  CHECK (ring_init (), "ring_init");
+  CHECK (create ("rate", PIECE_SIZE * PIECE_CNT), "create \"rate\"");
+  CHECK ((fd = open ("rate")) > 1, "open \"rate\"");
+
+  start = rdtsc ();
+  write_plain (fd);
+  msg ("system calls: %u cycles per write",
+       (unsigned) ((rdtsc () - start) / PIECE_CNT));
+
+  start = rdtsc ();
+  write_ring (fd);
+  msg ("rings: %u cycles per write",
+       (unsigned) ((rdtsc () - start) / PIECE_CNT));
+
+  close (fd);
+}
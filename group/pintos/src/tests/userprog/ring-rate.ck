@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+s/^\(ring-rate\) (.*): \d+ cycles per write$/(ring-rate) $1: N cycles per write/
+  foreach @output;
+compare_output ("run", IGNORE_EXIT_CODES => 1, \@output, [<<'EOF']);
+(ring-rate) begin
+(ring-rate) ring_init
+(ring-rate) create "rate"
+(ring-rate) open "rate"
+(ring-rate) system calls: N cycles per write
+(ring-rate) rings: N cycles per write
+(ring-rate) end
+EOF
+pass;
@@ -0,0 +1,57 @@
+/* Measures the cost of system call round trips: one that takes
+   no pointers, one that copies a buffer out to user memory, and
+   a pair that copies a file name in. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Round trips timed for each kind of call. */
+#define ITERATIONS 1000
+
+/* Returns the average number of cycles since START over
+   ITERATIONS iterations. */
+static unsigned
+per_iteration (uint64_t start)
+{
+  return (rdtsc () - start) / ITERATIONS;
+}
+
+void
+test_main (void)
+{
+  char buf[64];
+  uint64_t start;
+  int fd;
+  int i;
+
+  CHECK ((fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  start = rdtsc ();
+  for (i = 0; i < ITERATIONS; i++)
+    if (practice (i) != i + 1)
+      fail ("practice (%d) returned wrong value", i);
+  msg ("practice: %u cycles per call", per_iteration (start));
+
+  start = rdtsc ();
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      seek (fd, 0);
+      if (read (fd, buf, sizeof buf) != sizeof buf)
+        fail ("read \"sample.txt\" failed");
+    }
+  msg ("seek and read: %u cycles per pair", per_iteration (start));
+
+  start = rdtsc ();
+  for (i = 0; i < ITERATIONS; i++)
+    {
+      int fd2 = open ("sample.txt");
+      if (fd2 < 2)
+        fail ("open \"sample.txt\" failed");
+      close (fd2);
+    }
+  msg ("open and close: %u cycles per pair", per_iteration (start));
+
+  close (fd);
+}
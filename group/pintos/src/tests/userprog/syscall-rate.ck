@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+s/^\(syscall-rate\) (.*): \d+ cycles per (call|pair)$/(syscall-rate) $1: N cycles per $2/
+  foreach @output;
+compare_output ("run", IGNORE_EXIT_CODES => 1, \@output, [<<'EOF']);
+(syscall-rate) begin
+(syscall-rate) open "sample.txt"
+(syscall-rate) practice: N cycles per call
+(syscall-rate) seek and read: N cycles per pair
+(syscall-rate) open and close: N cycles per pair
+(syscall-rate) end
+EOF
+pass;
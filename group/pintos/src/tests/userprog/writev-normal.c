@@ -0,0 +1,30 @@
+/* Writes a file from three buffers with one writev() call, one
+   of them empty. */
+
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  size_t size = sizeof sample - 1;
+  struct iovec iov[3] =
+    {
+      {sample, 20},
+      {sample + 20, 0},
+      {sample + 20, size - 20},
+    };
+  int handle, byte_cnt;
+
+  CHECK (create ("test.txt", size), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  byte_cnt = writev (handle, iov, 3);
+  if (byte_cnt != (int) size)
+    fail ("writev() returned %d instead of %zu", byte_cnt, size);
+  close (handle);
+
+  check_file ("test.txt", sample, size);
+}
@@ -0,0 +1,27 @@
+/* Child process of page-lazy.
+   Has 8 MB of uninitialized data, more than the physical memory
+   that Pintos has to give to user processes, but touches only a
+   few pages of it.  Such a process can only be run if pages are
+   brought in when they are first touched. */
+
+#include "tests/lib.h"
+#include "tests/main.h"
+
+const char *test_name = "child-lazy";
+
+#define SIZE (8 * 1024 * 1024)
+static char buf[SIZE];
+
+int
+main (int argc UNUSED, char *argv[] UNUSED)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i += SIZE / 4)
+    {
+      if (buf[i] != 0)
+        fail ("byte %zu is nonzero", i);
+      buf[i] = 1;
+    }
+  return 0x42;
+}
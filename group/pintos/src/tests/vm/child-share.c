@@ -0,0 +1,25 @@
+/* Child process of page-share.  Runs some code and exits with
+   code 0x42.  Many copies of it run at once, and they should all
+   share the frames holding its code. */
+
+#include <string.h>
+#include "tests/arc4.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+const char *test_name = "child-share";
+
+int
+main (int argc UNUSED, char *argv[] UNUSED)
+{
+  static char buf[1024];
+  struct arc4 arc4;
+
+  arc4_init (&arc4, "child-share", 11);
+  arc4_crypt (&arc4, buf, sizeof buf);
+  arc4_init (&arc4, "child-share", 11);
+  arc4_crypt (&arc4, buf, sizeof buf);
+  if (memchr (buf, 1, sizeof buf) != NULL)
+    fail ("arc4 did not decrypt");
+  return 0x42;
+}
@@ -0,0 +1,78 @@
+/* Scans a 256 kB file twice, once by read() into a buffer a page
+   at a time and once through a memory mapping, checks that both
+   see the same data, and reports how many CPU cycles each took
+   per page. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/arc4.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define FILE_SIZE (256 * 1024)
+#define PAGE_CNT (FILE_SIZE / PAGE_SIZE)
+
+static uint32_t buf[PAGE_SIZE / sizeof (uint32_t)];
+
+/* Returns the sum of the CNT words at P. */
+static uint32_t
+sum_words (const uint32_t *p, size_t cnt)
+{
+  uint32_t sum = 0;
+  size_t i;
+
+  for (i = 0; i < cnt; i++)
+    sum += p[i];
+  return sum;
+}
+
+void
+test_main (void)
+{
+  uint32_t *map_base = (uint32_t *) 0x10000000;
+  struct arc4 arc4;
+  uint32_t read_sum, mmap_sum;
+  uint64_t start, read_cycles, mmap_cycles;
+  mapid_t map;
+  int handle;
+  size_t i;
+
+  CHECK (create ("big", FILE_SIZE), "create \"big\"");
+  CHECK ((handle = open ("big")) > 1, "open \"big\"");
+  msg ("write \"big\"");
+  arc4_init (&arc4, "mmap-scan", 9);
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      arc4_crypt (&arc4, buf, sizeof buf);
+      if (write (handle, buf, sizeof buf) != sizeof buf)
+        fail ("write \"big\" failed");
+    }
+
+  msg ("scan \"big\" with read");
+  seek (handle, 0);
+  read_sum = 0;
+  start = rdtsc ();
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      if (read (handle, buf, sizeof buf) != sizeof buf)
+        fail ("read \"big\" failed");
+      read_sum += sum_words (buf, PAGE_SIZE / sizeof *buf);
+    }
+  read_cycles = rdtsc () - start;
+
+  msg ("scan \"big\" with mmap");
+  start = rdtsc ();
+  map = mmap (handle, map_base);
+  if (map == MAP_FAILED)
+    fail ("mmap \"big\" failed");
+  mmap_sum = sum_words (map_base, FILE_SIZE / sizeof *map_base);
+  munmap (map);
+  mmap_cycles = rdtsc () - start;
+
+  if (read_sum != mmap_sum)
+    fail ("read and mmap scans disagree");
+  msg ("read: %llu cycles per page", read_cycles / PAGE_CNT);
+  msg ("mmap: %llu cycles per page", mmap_cycles / PAGE_CNT);
+  close (handle);
+}
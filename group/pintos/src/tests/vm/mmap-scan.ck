@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+s/^\((mmap-scan)\) (read|mmap): \d+ cycles per page$/($1) $2: N cycles per page/
+  foreach @output;
+compare_output ("run", IGNORE_EXIT_CODES => 1, \@output, [<<'EOF']);
+(mmap-scan) begin
+(mmap-scan) create "big"
+(mmap-scan) open "big"
+(mmap-scan) write "big"
+(mmap-scan) scan "big" with read
+(mmap-scan) scan "big" with mmap
+(mmap-scan) read: N cycles per page
+(mmap-scan) mmap: N cycles per page
+(mmap-scan) end
+EOF
+pass;
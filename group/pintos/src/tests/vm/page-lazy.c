@@ -0,0 +1,16 @@
+/* Runs a child process whose uninitialized data is larger than
+   physical memory, which can only work if its pages are only
+   brought in when touched. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  pid_t child;
+
+  CHECK ((child = exec ("child-lazy")) != -1, "exec \"child-lazy\"");
+  CHECK (wait (child) == 0x42, "wait for child-lazy");
+}
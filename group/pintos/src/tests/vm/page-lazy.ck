@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-lazy) begin
+(page-lazy) exec "child-lazy"
+(page-lazy) wait for child-lazy
+(page-lazy) end
+EOF
+pass;
@@ -0,0 +1,58 @@
+/* Touches the pages of a 3 MB array, more than fits in the user
+   pool, in random order, so that nearly every touch has to evict
+   some other page, and then checks that every page kept what was
+   written to it.  The "Page:", "Frame:", and "Swap:" statistics
+   that the kernel prints on shutdown show how fast the faults
+   were served and how the evictions were batched. */
+
+#include <inttypes.h>
+#include "tests/arc4.h"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (3 * 1024 * 1024)
+#define PAGE_WORDS (4096 / sizeof (uint32_t))
+#define PAGE_CNT (SIZE / 4096)
+#define TOUCH_CNT (4 * PAGE_CNT)
+
+static uint32_t buf[SIZE / sizeof (uint32_t)];
+static uint32_t touches[PAGE_CNT];
+
+/* Returns a random page number. */
+static size_t
+random_page (struct arc4 *arc4)
+{
+  uint32_t r = 0;
+
+  arc4_crypt (arc4, &r, sizeof r);
+  return r % PAGE_CNT;
+}
+
+void
+test_main (void)
+{
+  struct arc4 arc4;
+  size_t i;
+
+  msg ("touch pages in random order");
+  arc4_init (&arc4, "pressure", 8);
+  for (i = 0; i < TOUCH_CNT; i++)
+    {
+      size_t page = random_page (&arc4);
+      buf[page * PAGE_WORDS + i % PAGE_WORDS] += page;
+      touches[page]++;
+    }
+
+  msg ("check pages");
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      uint32_t sum = 0;
+      size_t j;
+
+      for (j = 0; j < PAGE_WORDS; j++)
+        sum += buf[i * PAGE_WORDS + j];
+      if (sum != touches[i] * i)
+        fail ("page %zu has sum %"PRIu32" after %"PRIu32" touches",
+              i, sum, touches[i]);
+    }
+}
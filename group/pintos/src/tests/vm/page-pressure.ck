@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-pressure) begin
+(page-pressure) touch pages in random order
+(page-pressure) check pages
+(page-pressure) end
+EOF
+pass;
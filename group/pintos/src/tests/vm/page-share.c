@@ -0,0 +1,34 @@
+/* Runs many copies of one program at the same time and reports
+   how long exec() took for each on average.  All of the copies
+   should map the same frames for the program's code, which the
+   "Share:" and "Process:" statistics that the kernel prints on
+   shutdown show. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 8
+
+void
+test_main (void)
+{
+  pid_t children[CHILD_CNT];
+  uint64_t start, cycles;
+  size_t i;
+
+  msg ("exec %d copies of \"child-share\"", CHILD_CNT);
+  start = rdtsc ();
+  for (i = 0; i < CHILD_CNT; i++)
+    if ((children[i] = exec ("child-share")) == -1)
+      fail ("exec \"child-share\" failed");
+  cycles = rdtsc () - start;
+
+  msg ("wait for children");
+  for (i = 0; i < CHILD_CNT; i++)
+    if (wait (children[i]) != 0x42)
+      fail ("child %zu failed", i);
+
+  msg ("exec: %llu cycles each on average", cycles / CHILD_CNT);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+our ($test);
+my (@output) = read_text_file ("$test.output");
+common_checks ("run", @output);
+s/^\(page-share\) exec: \d+ cycles each on average$/(page-share) exec: N cycles each on average/
+  foreach @output;
+compare_output ("run", IGNORE_EXIT_CODES => 1, \@output, [<<'EOF']);
+(page-share) begin
+(page-share) exec 8 copies of "child-share"
+(page-share) wait for children
+(page-share) exec: N cycles each on average
+(page-share) end
+EOF
+pass;
@@ -359,6 +359,12 @@ intr_handler (struct intr_frame *frame)
 
       in_external_intr = true;
       yield_on_return = false;
+
+      /* A device interrupt may end a tickless idle period, so
+         bring the tick count up to date before handling it.  The
+         timer interrupt takes care of this itself. */
+      if (frame->vec_no != 0x20)
+        timer_catch_up ();
     }
 
   /* Invoke the interrupt's handler. */
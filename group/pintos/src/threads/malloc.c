@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -13,21 +14,32 @@
 
    The size of each request, in bytes, is rounded up to a power
    of 2 and assigned to the "descriptor" that manages blocks of
-   that size.  The descriptor keeps a list of free blocks.  If
+   that size.  A table indexed by size finds the descriptor in
+   constant time.  The descriptor keeps a list of free blocks.  If
    the free list is nonempty, one of its blocks is used to
    satisfy the request.
 
    Otherwise, a new page of memory, called an "arena", is
    obtained from the page allocator (if none is available,
    malloc() returns a null pointer).  The new arena is divided
-   into blocks, all of which are added to the descriptor's free
-   list.  Then we return one of the new blocks.
+   into blocks lazily: blocks are carved off the arena one at a
+   time as they are needed, so creating an arena does not touch
+   all of it.
 
    When we free a block, we add it to its descriptor's free list.
    But if the arena that the block was in now has no in-use
    blocks, we remove all of the arena's blocks from the free list
    and give the arena back to the page allocator.
 
+   Each descriptor's lock may sleep, so in front of each
+   descriptor sits a "magazine", a small stack of free blocks
+   that malloc() and free() use with just interrupts turned off.
+   An empty magazine is refilled from the descriptor, and a full
+   one drained to it, MAG_BATCH blocks at a time under a single
+   acquisition of the descriptor's lock.  Blocks in a magazine
+   count as in use as far as their arena is concerned.  There is
+   one set of magazines per CPU, which in Pintos means one.
+
    We can't handle blocks bigger than 2 kB using this scheme,
    because they're too big to fit in a single page with a
    descriptor.  We handle those by allocating contiguous pages
@@ -40,6 +52,7 @@ struct desc
     size_t block_size;          /* Size of each element in bytes. */
     size_t blocks_per_arena;    /* Number of blocks in an arena. */
     struct list free_list;      /* List of free blocks. */
+    struct arena *carving;      /* Arena with blocks left to carve. */
     struct lock lock;           /* Lock. */
   };
 
@@ -52,6 +65,7 @@ struct arena
     unsigned magic;             /* Always set to ARENA_MAGIC. */
     struct desc *desc;          /* Owning descriptor, null for big block. */
     size_t free_cnt;            /* Free blocks; pages in big block. */
+    size_t carved_cnt;          /* Blocks carved so far. */
   };
 
 /* Free block. */
@@ -60,28 +74,67 @@ struct block
     struct list_elem free_elem; /* Free list element. */
   };
 
+/* Smallest and largest block sizes handled by descriptors. */
+#define MIN_BLOCK_SIZE 16
+#define MAX_BLOCK_SIZE (PGSIZE / 4)
+
 /* Our set of descriptors. */
 static struct desc descs[10];   /* Descriptors. */
 static size_t desc_cnt;         /* Number of descriptors. */
 
+/* Maps (SIZE - 1) / MIN_BLOCK_SIZE to the index in descs[] of the
+   smallest descriptor for SIZE-byte requests. */
+static uint8_t size_classes[MAX_BLOCK_SIZE / MIN_BLOCK_SIZE];
+
+/* Magazine. */
+#define MAG_SIZE 32             /* Capacity of a magazine. */
+#define MAG_BATCH 16            /* Blocks moved per refill or drain. */
+struct magazine
+  {
+    size_t cnt;                         /* Number of blocks. */
+    struct block *blocks[MAG_SIZE];     /* Free blocks. */
+  };
+
+/* The magazines of the boot CPU, one per descriptor. */
+static struct magazine magazines[sizeof descs / sizeof *descs];
+
+/* See malloc.h. */
+bool malloc_magazines = true;
+
 static struct arena *block_to_arena (struct block *);
 static struct block *arena_to_block (struct arena *, size_t idx);
+static struct block *desc_get_block (struct desc *);
+static void desc_put_block (struct desc *, struct block *);
+static void *malloc_refill (struct desc *, struct magazine *);
+static void free_drain (struct desc *, struct magazine *, struct block *);
 
 /* Initializes the malloc() descriptors. */
 void
 malloc_init (void)
 {
   size_t block_size;
+  size_t i;
 
-  for (block_size = 16; block_size < PGSIZE / 2; block_size *= 2)
+  for (block_size = MIN_BLOCK_SIZE; block_size <= MAX_BLOCK_SIZE;
+       block_size *= 2)
     {
       struct desc *d = &descs[desc_cnt++];
       ASSERT (desc_cnt <= sizeof descs / sizeof *descs);
       d->block_size = block_size;
       d->blocks_per_arena = (PGSIZE - sizeof (struct arena)) / block_size;
       list_init (&d->free_list);
+      d->carving = NULL;
       lock_init (&d->lock);
     }
+
+  for (i = 0; i < sizeof size_classes / sizeof *size_classes; i++)
+    {
+      size_t size = (i + 1) * MIN_BLOCK_SIZE;
+      struct desc *d = descs;
+      while (d->block_size < size)
+        d++;
+      size_classes[i] = d - descs;
+    }
 }
 
 /* Obtains and returns a new block of at least SIZE bytes.
@@ -90,19 +143,16 @@ void *
 malloc (size_t size)
 {
   struct desc *d;
+  struct magazine *m;
   struct block *b;
   struct arena *a;
+  enum intr_level old_level;
 
   /* A null pointer satisfies a request for 0 bytes. */
   if (size == 0)
     return NULL;
 
-  /* Find the smallest descriptor that satisfies a SIZE-byte
-     request. */
-  for (d = descs; d < descs + desc_cnt; d++)
-    if (d->block_size >= size)
-      break;
-  if (d == descs + desc_cnt)
+  if (size > MAX_BLOCK_SIZE)
     {
       /* SIZE is too big for any descriptor.
          Allocate enough pages to hold SIZE plus an arena. */
@@ -119,37 +169,106 @@ malloc (size_t size)
       return a + 1;
     }
 
+  /* Find the smallest descriptor that satisfies a SIZE-byte
+     request. */
+  d = &descs[size_classes[(size - 1) / MIN_BLOCK_SIZE]];
+
+  if (!malloc_magazines)
+    {
+      lock_acquire (&d->lock);
+      b = desc_get_block (d);
+      lock_release (&d->lock);
+      return b;
+    }
+
+  /* Take a block from the magazine, if it has one. */
+  m = &magazines[d - descs];
+  old_level = intr_disable ();
+  b = m->cnt > 0 ? m->blocks[--m->cnt] : NULL;
+  intr_set_level (old_level);
+  if (b != NULL)
+    return b;
+
+  return malloc_refill (d, m);
+}
+
+/* Takes up to MAG_BATCH blocks from descriptor D, returns one of
+   them, and puts the rest in D's magazine M.  Returns a null
+   pointer if memory is not available. */
+static void *
+malloc_refill (struct desc *d, struct magazine *m)
+{
+  struct block *batch[MAG_BATCH];
+  size_t cnt = 0;
+  enum intr_level old_level;
+
   lock_acquire (&d->lock);
+  while (cnt < MAG_BATCH)
+    {
+      struct block *b = desc_get_block (d);
+      if (b == NULL)
+        break;
+      batch[cnt++] = b;
+    }
+  lock_release (&d->lock);
+  if (cnt == 0)
+    return NULL;
 
-  /* If the free list is empty, create a new arena. */
-  if (list_empty (&d->free_list))
+  /* Other threads may have filled the magazine while we waited
+     for the lock, so it might not take all of the batch. */
+  old_level = intr_disable ();
+  while (cnt > 1 && m->cnt < MAG_SIZE)
+    m->blocks[m->cnt++] = batch[--cnt];
+  intr_set_level (old_level);
+
+  if (cnt > 1)
     {
-      size_t i;
+      lock_acquire (&d->lock);
+      while (cnt > 1)
+        desc_put_block (d, batch[--cnt]);
+      lock_release (&d->lock);
+    }
+  return batch[0];
+}
+
+/* Takes a free block from descriptor D, creating a new arena if
+   necessary.  Returns a null pointer if memory is not available.
+   D's lock must be held. */
+static struct block *
+desc_get_block (struct desc *d)
+{
+  struct block *b;
+  struct arena *a;
 
-      /* Allocate a page. */
-      a = palloc_get_page (0);
+  ASSERT (lock_held_by_current_thread (&d->lock));
+
+  if (!list_empty (&d->free_list))
+    {
+      b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
+      a = block_to_arena (b);
+    }
+  else
+    {
+      /* If there is no arena to carve, create one. */
+      a = d->carving;
       if (a == NULL)
         {
-          lock_release (&d->lock);
-          return NULL;
+          a = palloc_get_page (0);
+          if (a == NULL)
+            return NULL;
+          a->magic = ARENA_MAGIC;
+          a->desc = d;
+          a->free_cnt = d->blocks_per_arena;
+          a->carved_cnt = 0;
+          d->carving = a;
         }
 
-      /* Initialize arena and add its blocks to the free list. */
-      a->magic = ARENA_MAGIC;
-      a->desc = d;
-      a->free_cnt = d->blocks_per_arena;
-      for (i = 0; i < d->blocks_per_arena; i++)
-        {
-          struct block *b = arena_to_block (a, i);
-          list_push_back (&d->free_list, &b->free_elem);
-        }
+      /* Carve off the next block. */
+      b = arena_to_block (a, a->carved_cnt++);
+      if (a->carved_cnt == d->blocks_per_arena)
+        d->carving = NULL;
     }
-
-  /* Get a block from free list and return it. */
-  b = list_entry (list_pop_front (&d->free_list), struct block, free_elem);
-  a = block_to_arena (b);
   a->free_cnt--;
-  lock_release (&d->lock);
   return b;
 }
 
@@ -227,32 +346,32 @@ free (void *p)
       if (d != NULL)
         {
           /* It's a normal block.  We handle it here. */
+          struct magazine *m = &magazines[d - descs];
+          enum intr_level old_level;
 
 #ifndef NDEBUG
           /* Clear the block to help detect use-after-free bugs. */
           memset (b, 0xcc, d->block_size);
 #endif
 
-          lock_acquire (&d->lock);
-
-          /* Add block to free list. */
-          list_push_front (&d->free_list, &b->free_elem);
-
-          /* If the arena is now entirely unused, free it. */
-          if (++a->free_cnt >= d->blocks_per_arena)
+          if (!malloc_magazines)
             {
-              size_t i;
-
-              ASSERT (a->free_cnt == d->blocks_per_arena);
-              for (i = 0; i < d->blocks_per_arena; i++)
-                {
-                  struct block *b = arena_to_block (a, i);
-                  list_remove (&b->free_elem);
-                }
-              palloc_free_page (a);
+              lock_acquire (&d->lock);
+              desc_put_block (d, b);
+              lock_release (&d->lock);
+              return;
             }
 
-          lock_release (&d->lock);
+          /* Put the block in the magazine, if it has room. */
+          old_level = intr_disable ();
+          if (m->cnt < MAG_SIZE)
+            {
+              m->blocks[m->cnt++] = b;
+              b = NULL;
+            }
+          intr_set_level (old_level);
+          if (b != NULL)
+            free_drain (d, m, b);
         }
       else
         {
@@ -263,6 +382,57 @@ free (void *p)
     }
 }
 
+/* Returns block B, and up to MAG_BATCH - 1 blocks from D's full
+   magazine M, to descriptor D. */
+static void
+free_drain (struct desc *d, struct magazine *m, struct block *b)
+{
+  struct block *batch[MAG_BATCH];
+  size_t cnt = 0;
+  enum intr_level old_level;
+
+  batch[cnt++] = b;
+  old_level = intr_disable ();
+  while (cnt < MAG_BATCH && m->cnt > 0)
+    batch[cnt++] = m->blocks[--m->cnt];
+  intr_set_level (old_level);
+
+  lock_acquire (&d->lock);
+  while (cnt > 0)
+    desc_put_block (d, batch[--cnt]);
+  lock_release (&d->lock);
+}
+
+/* Adds block B to descriptor D's free list, and frees B's arena
+   if none of its blocks remain in use.  D's lock must be
+   held. */
+static void
+desc_put_block (struct desc *d, struct block *b)
+{
+  struct arena *a = block_to_arena (b);
+
+  ASSERT (lock_held_by_current_thread (&d->lock));
+
+  /* Add block to free list. */
+  list_push_front (&d->free_list, &b->free_elem);
+
+  /* If the arena is now entirely unused, free it. */
+  if (++a->free_cnt >= d->blocks_per_arena)
+    {
+      size_t i;
+
+      ASSERT (a->free_cnt == d->blocks_per_arena);
+      for (i = 0; i < a->carved_cnt; i++)
+        {
+          struct block *b = arena_to_block (a, i);
+          list_remove (&b->free_elem);
+        }
+      if (d->carving == a)
+        d->carving = NULL;
+      palloc_free_page (a);
+    }
+}
+
 /* Returns the arena that block B is inside. */
 static struct arena *
 block_to_arena (struct block *b)
@@ -2,8 +2,14 @@
 #define THREADS_MALLOC_H
 
 #include <debug.h>
+#include <stdbool.h>
 #include <stddef.h>
 
+/* If true (default), malloc() and free() keep a small cache of
+   free blocks of each size that they use without taking a lock.
+   Turned off by the malloc-rate test to measure the difference. */
+extern bool malloc_magazines;
+
 void malloc_init (void);
 void *malloc (size_t) __attribute__ ((malloc));
 void *calloc (size_t, size_t) __attribute__ ((malloc));
@@ -2,13 +2,16 @@
 #include <bitmap.h>
 #include <debug.h>
 #include <inttypes.h>
+#include <list.h>
 #include <round.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -25,20 +28,96 @@
    half to the user pool.  That should be huge overkill for the
    kernel pool, but that's just fine for demonstration purposes. */
 
-/* A memory pool. */
+/* Free pages are managed by a binary buddy system.  The pages
+   of a pool are grouped into free "blocks" of 2**ORDER pages,
+   each aligned, relative to the start of the pool, on a multiple
+   of its size, and kept on a list per order.  An allocation
+   takes the smallest block big enough, splitting it in halves as
+   needed; freeing a block merges it with its "buddy", the other
+   half of the next bigger block, for as long as the buddy is
+   free too.  Both take time logarithmic in the size of the pool.
+
+   Requests for a number of pages that is not a power of 2 are
+   rounded up to the next one, and the unneeded tail of the block
+   is freed again at once, so that palloc_free_multiple() can be
+   given any run of pages that was allocated.
+
+   The free lists do not live in the free pages themselves but
+   in an array of `struct page_info', one per page, at the
+   start of the pool, next to the bitmap of used pages.
+
+   Zeroing pages for PAL_ZERO requests is kept off the critical
+   path where possible: the idle thread, and a low-priority
+   "zero" thread woken when requests outrun it, take free pages
+   out of the buddy system, zero them, and keep them on a list of
+   their own, from which PAL_ZERO requests for single pages are
+   served first.  If the buddy system runs dry, the zeroed pages
+   go back into it, and a request that still cannot be met while
+   a page is out being zeroed waits for that page and tries
+   again, so zeroing ahead never makes an allocation fail.  The
+   exception is a request from an interrupt handler, which cannot
+   wait. */
+
+/* Number of block sizes, enough for any pool. */
+#define ORDER_CNT 20
+
+/* Per-page information. */
+struct page_info
+  {
+    struct list_elem elem;      /* Element in pool's free_lists[]. */
+    int order;                  /* Order of free block starting here,
+                                   -1 if none does. */
+  };
+
+/* A memory pool.  Its members are only changed with interrupts
+   off. */
 struct pool
   {
-    struct lock lock;                   /* Mutual exclusion. */
     struct bitmap *used_map;            /* Bitmap of free pages. */
+    struct page_info *pages;            /* One per page. */
     uint8_t *base;                      /* Base of pool. */
+    size_t page_cnt;                    /* Number of pages. */
+    size_t free_cnt;                    /* Number of free pages. */
+    struct list free_lists[ORDER_CNT];  /* Free blocks of each order. */
+    size_t block_cnt[ORDER_CNT];        /* Length of each free list. */
+    uint32_t nonempty;                  /* Bit K set if free_lists[K]
+                                           is nonempty. */
+
+    /* Pages zeroed ahead of time. */
+    struct list zeroed_list;            /* Zeroed free pages. */
+    size_t zeroed_cnt;                  /* Length of zeroed_list. */
+    size_t zeroed_max;                  /* Length to keep it at. */
+    unsigned long long zero_hits;       /* PAL_ZERO served from list. */
+    unsigned long long zero_misses;     /* PAL_ZERO zeroed on demand. */
+    size_t zeroing_cnt;                 /* Pages out being zeroed. */
+    size_t zero_waiters;                /* Requests waiting for them. */
+    struct semaphore zeroing_done;      /* Upped for each such request
+                                           when one comes back. */
   };
 
+/* Most pages to keep zeroed ahead of time in a pool. */
+#define ZEROED_MAX 64
+
+/* Returned by alloc_block() on failure. */
+#define PAGE_ERROR SIZE_MAX
+
 /* Two pools: one for kernel data, one for user pages. */
 static struct pool kernel_pool, user_pool;
 
+/* Wakes up the zero thread. */
+static struct semaphore zero_sema;
+static bool zero_wanted;
+
 static void init_pool (struct pool *, void *base, size_t page_cnt,
                        const char *name);
 static bool page_from_pool (const struct pool *, void *page);
+static int order_for (size_t page_cnt);
+static size_t alloc_block (struct pool *, int order);
+static void free_range (struct pool *, size_t page_idx, size_t page_cnt);
+static void drain_zeroed (struct pool *);
+static bool zero_page (struct pool *);
+static thread_func zero_thread;
+static void print_pool_stats (struct pool *, const char *name);
 
 /* Initializes the page allocator.  At most USER_PAGE_LIMIT
    pages are put into the user pool. */
@@ -59,6 +138,20 @@ palloc_init (size_t user_page_limit)
   init_pool (&kernel_pool, free_start, kernel_pages, "kernel pool");
   init_pool (&user_pool, free_start + kernel_pages * PGSIZE,
              user_pages, "user pool");
+  sema_init (&zero_sema, 0);
+}
+
+/* Starts the thread that zeroes free pages when the idle thread
+   falls behind.  Must be called after thread_start().
+
+   The MLFQS ignores the priority given to thread_create() and
+   would count the zero thread toward the load average whenever
+   it ran, so under the MLFQS only the idle thread zeroes pages. */
+void
+palloc_start (void)
+{
+  if (!thread_mlfqs)
+    thread_create ("zero", PRI_MIN, zero_thread, NULL);
 }
 
 /* Obtains and returns a group of PAGE_CNT contiguous free pages.
@@ -72,23 +165,77 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
 {
   struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
   void *pages;
-  size_t page_idx;
+  size_t page_idx = PAGE_ERROR;
+  bool zeroed = false;
+  bool wake = false;
+  int order;
 
   if (page_cnt == 0)
     return NULL;
 
-  lock_acquire (&pool->lock);
-  page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-  lock_release (&pool->lock);
+  order = order_for (page_cnt);
+  if (order < ORDER_CNT)
+    {
+      enum intr_level old_level = intr_disable ();
+      if ((flags & PAL_ZERO) && page_cnt == 1 && pool->zeroed_cnt > 0)
+        {
+          /* Take a page that is already zeroed. */
+          struct list_elem *e = list_pop_front (&pool->zeroed_list);
+          page_idx = list_entry (e, struct page_info, elem) - pool->pages;
+          pool->zeroed_cnt--;
+          pool->zero_hits++;
+          zeroed = true;
+        }
+      else
+        {
+          for (;;)
+            {
+              page_idx = alloc_block (pool, order);
+              if (page_idx == PAGE_ERROR && pool->zeroed_cnt > 0)
+                {
+                  drain_zeroed (pool);
+                  page_idx = alloc_block (pool, order);
+                }
+              if (page_idx != PAGE_ERROR || pool->zeroing_cnt == 0
+                  || intr_context ())
+                break;
+
+              /* Wait for the pages being zeroed to come back. */
+              pool->zero_waiters++;
+              sema_down (&pool->zeroing_done);
+            }
+          if (page_idx != PAGE_ERROR)
+            {
+              /* Give back the part of the block we don't need. */
+              free_range (pool, page_idx + page_cnt,
+                          ((size_t) 1 << order) - page_cnt);
+              pool->free_cnt -= page_cnt;
+              if (flags & PAL_ZERO)
+                pool->zero_misses++;
+            }
+        }
+      if (page_idx != PAGE_ERROR)
+        {
+          ASSERT (bitmap_none (pool->used_map, page_idx, page_cnt));
+          bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+        }
+      if (!thread_mlfqs && (flags & PAL_ZERO)
+          && pool->zeroed_cnt < pool->zeroed_max / 2 && !zero_wanted)
+        zero_wanted = wake = true;
+      intr_set_level (old_level);
+    }
+
+  if (wake)
+    sema_up (&zero_sema);
 
-  if (page_idx != BITMAP_ERROR)
+  if (page_idx != PAGE_ERROR)
     pages = pool->base + PGSIZE * page_idx;
   else
     pages = NULL;
 
   if (pages != NULL)
     {
-      if (flags & PAL_ZERO)
+      if ((flags & PAL_ZERO) && !zeroed)
         memset (pages, 0, PGSIZE * page_cnt);
     }
   else
@@ -119,6 +266,7 @@ palloc_free_multiple (void *pages, size_t page_cnt)
 {
   struct pool *pool;
   size_t page_idx;
+  enum intr_level old_level;
 
   ASSERT (pg_ofs (pages) == 0);
   if (pages == NULL || page_cnt == 0)
@@ -137,8 +285,12 @@ palloc_free_multiple (void *pages, size_t page_cnt)
   memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
 
+  old_level = intr_disable ();
   ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
   bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+  free_range (pool, page_idx, page_cnt);
+  pool->free_cnt += page_cnt;
+  intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -148,25 +300,69 @@ palloc_free_page (void *page)
   palloc_free_multiple (page, 1);
 }
 
+/* Zeroes a free page ahead of time for a later PAL_ZERO request,
+   if a pool is short of zeroed pages and has a free page to
+   spare.  Returns true if it zeroed a page, false if there was
+   nothing to do.  Called by the idle thread. */
+bool
+palloc_zero_page (void)
+{
+  return zero_page (&kernel_pool) || zero_page (&user_pool);
+}
+
+/* Prints the number of free blocks of each order in each pool.
+   For each order, also prints the share of the free pages that
+   are in smaller blocks, that is, that cannot be used to satisfy
+   a request for that many pages. */
+void
+palloc_print_stats (void)
+{
+  print_pool_stats (&kernel_pool, "kernel");
+  print_pool_stats (&user_pool, "user");
+}
+
 /* Initializes pool P as starting at START and ending at END,
    naming it NAME for debugging purposes. */
 static void
 init_pool (struct pool *p, void *base, size_t page_cnt, const char *name)
 {
-  /* We'll put the pool's used_map at its base.
-     Calculate the space needed for the bitmap
-     and subtract it from the pool's size. */
-  size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (page_cnt), PGSIZE);
-  if (bm_pages > page_cnt)
+  /* We'll put the pool's used_map and page information at its
+     base.  Calculate the space needed for them and subtract it
+     from the pool's size. */
+  size_t bm_size = bitmap_buf_size (page_cnt);
+  size_t hdr_pages = DIV_ROUND_UP (bm_size
+                                   + page_cnt * sizeof (struct page_info),
+                                   PGSIZE);
+  size_t i;
+  if (hdr_pages > page_cnt)
     PANIC ("Not enough memory in %s for bitmap.", name);
-  page_cnt -= bm_pages;
+  page_cnt -= hdr_pages;
 
   printf ("%zu pages available in %s.\n", page_cnt, name);
 
   /* Initialize the pool. */
-  lock_init (&p->lock);
-  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
-  p->base = base + bm_pages * PGSIZE;
+  p->used_map = bitmap_create_in_buf (page_cnt, base, bm_size);
+  p->pages = (struct page_info *) ((uint8_t *) base + bm_size);
+  p->base = base + hdr_pages * PGSIZE;
+  p->page_cnt = page_cnt;
+  for (i = 0; i < ORDER_CNT; i++)
+    {
+      list_init (&p->free_lists[i]);
+      p->block_cnt[i] = 0;
+    }
+  p->nonempty = 0;
+  list_init (&p->zeroed_list);
+  p->zeroed_cnt = 0;
+  p->zeroed_max = page_cnt / 8 < ZEROED_MAX ? page_cnt / 8 : ZEROED_MAX;
+  p->zero_hits = p->zero_misses = 0;
+  p->zeroing_cnt = p->zero_waiters = 0;
+  sema_init (&p->zeroing_done, 0);
+  for (i = 0; i < page_cnt; i++)
+    p->pages[i].order = -1;
+
+  /* Every page starts out free. */
+  free_range (p, 0, page_cnt);
+  p->free_cnt = page_cnt;
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -176,7 +372,210 @@ page_from_pool (const struct pool *pool, void *page)
 {
   size_t page_no = pg_no (page);
   size_t start_page = pg_no (pool->base);
-  size_t end_page = start_page + bitmap_size (pool->used_map);
+  size_t end_page = start_page + pool->page_cnt;
 
   return page_no >= start_page && page_no < end_page;
 }
+
+/* Returns the smallest order whose blocks hold PAGE_CNT pages. */
+static int
+order_for (size_t page_cnt)
+{
+  return page_cnt <= 1 ? 0 : 32 - __builtin_clz (page_cnt - 1);
+}
+
+/* Adds the free block of the given ORDER at PAGE_IDX to P's free
+   lists. */
+static void
+push_block (struct pool *p, size_t page_idx, int order)
+{
+  struct page_info *pi = &p->pages[page_idx];
+
+  pi->order = order;
+  list_push_front (&p->free_lists[order], &pi->elem);
+  p->block_cnt[order]++;
+  p->nonempty |= 1u << order;
+}
+
+/* Removes the free block of the given ORDER at PAGE_IDX from P's
+   free lists. */
+static void
+remove_block (struct pool *p, size_t page_idx, int order)
+{
+  struct page_info *pi = &p->pages[page_idx];
+
+  ASSERT (pi->order == order);
+  pi->order = -1;
+  list_remove (&pi->elem);
+  if (--p->block_cnt[order] == 0)
+    p->nonempty &= ~(1u << order);
+}
+
+/* Takes a block of 2**ORDER pages from P's free lists, splitting
+   a bigger block if necessary, and returns the index of its first
+   page, or PAGE_ERROR if there is no block big enough. */
+static size_t
+alloc_block (struct pool *p, int order)
+{
+  uint32_t candidates = p->nonempty & ~((1u << order) - 1);
+  struct list_elem *e;
+  size_t page_idx;
+  int k;
+
+  if (candidates == 0)
+    return PAGE_ERROR;
+
+  k = __builtin_ctz (candidates);
+  e = list_front (&p->free_lists[k]);
+  page_idx = list_entry (e, struct page_info, elem) - p->pages;
+  remove_block (p, page_idx, k);
+
+  /* Put the upper halves back until the block is small enough. */
+  while (k > order)
+    {
+      k--;
+      push_block (p, page_idx + ((size_t) 1 << k), k);
+    }
+  return page_idx;
+}
+
+/* Returns the block of 2**ORDER pages at PAGE_IDX to P's free
+   lists, merging it with its buddy as long as that is free. */
+static void
+free_block (struct pool *p, size_t page_idx, int order)
+{
+  while (order < ORDER_CNT - 1)
+    {
+      size_t buddy = page_idx ^ ((size_t) 1 << order);
+      if (buddy >= p->page_cnt || p->pages[buddy].order != order)
+        break;
+      remove_block (p, buddy, order);
+      page_idx &= ~((size_t) 1 << order);
+      order++;
+    }
+  push_block (p, page_idx, order);
+}
+
+/* Returns the PAGE_CNT pages starting at PAGE_IDX to P's free
+   lists, as the fewest blocks that are properly aligned. */
+static void
+free_range (struct pool *p, size_t page_idx, size_t page_cnt)
+{
+  while (page_cnt > 0)
+    {
+      int order = 31 - __builtin_clz (page_cnt);
+      if (page_idx != 0 && __builtin_ctz (page_idx) < order)
+        order = __builtin_ctz (page_idx);
+      if (order > ORDER_CNT - 1)
+        order = ORDER_CNT - 1;
+
+      free_block (p, page_idx, order);
+      page_idx += (size_t) 1 << order;
+      page_cnt -= (size_t) 1 << order;
+    }
+}
+
+/* Returns all of P's zeroed pages to its free lists.
+   Interrupts must be off. */
+static void
+drain_zeroed (struct pool *p)
+{
+  while (!list_empty (&p->zeroed_list))
+    {
+      struct list_elem *e = list_pop_front (&p->zeroed_list);
+      free_range (p, list_entry (e, struct page_info, elem) - p->pages, 1);
+    }
+  p->free_cnt += p->zeroed_cnt;
+  p->zeroed_cnt = 0;
+}
+
+/* Takes a free page from P, if P is short of zeroed pages, and
+   zeroes it and puts it on P's zeroed list.  Returns true if
+   successful, false if there was nothing to do.  Wakes up any
+   requests that ran out of pages meanwhile. */
+static bool
+zero_page (struct pool *p)
+{
+  enum intr_level old_level;
+  size_t page_idx = PAGE_ERROR;
+  size_t waiters;
+
+  old_level = intr_disable ();
+  if (p->zeroed_cnt < p->zeroed_max && p->free_cnt > 0
+      && p->zero_waiters == 0)
+    {
+      page_idx = alloc_block (p, 0);
+      p->free_cnt--;
+      p->zeroing_cnt++;
+    }
+  intr_set_level (old_level);
+  if (page_idx == PAGE_ERROR)
+    return false;
+
+  /* The page belongs to no one while we zero it, so we can do
+     that with interrupts on. */
+  memset (p->base + PGSIZE * page_idx, 0, PGSIZE);
+
+  old_level = intr_disable ();
+  list_push_front (&p->zeroed_list, &p->pages[page_idx].elem);
+  p->zeroed_cnt++;
+  p->zeroing_cnt--;
+  waiters = p->zero_waiters;
+  p->zero_waiters = 0;
+  intr_set_level (old_level);
+
+  while (waiters-- > 0)
+    sema_up (&p->zeroing_done);
+  return true;
+}
+
+/* Zero thread.  Refills the pools' zeroed lists whenever
+   palloc_get_multiple() finds one running low. */
+static void
+zero_thread (void *aux UNUSED)
+{
+  for (;;)
+    {
+      sema_down (&zero_sema);
+      zero_wanted = false;
+      while (palloc_zero_page ())
+        continue;
+    }
+}
+
+/* Prints P's statistics under the given NAME. */
+static void
+print_pool_stats (struct pool *p, const char *name)
+{
+  size_t block_cnt[ORDER_CNT];
+  size_t free_cnt, zeroed_cnt, smaller;
+  unsigned long long hits, misses;
+  enum intr_level old_level;
+  int k;
+
+  old_level = intr_disable ();
+  memcpy (block_cnt, p->block_cnt, sizeof block_cnt);
+  free_cnt = p->free_cnt;
+  zeroed_cnt = p->zeroed_cnt;
+  hits = p->zero_hits;
+  misses = p->zero_misses;
+  intr_set_level (old_level);
+
+  printf ("Palloc: %s pool: %zu of %zu pages free, %zu more zeroed\n",
+          name, free_cnt, p->page_cnt, zeroed_cnt);
+  printf ("Palloc: %s pool: %llu zeroed pages used, %llu zeroed on demand",
+          name, hits, misses);
+  if (hits + misses > 0)
+    printf (", %llu%% hit rate", hits * 100 / (hits + misses));
+  printf ("\n");
+  smaller = 0;
+  for (k = 0; k < ORDER_CNT && ((size_t) 1 << k) <= p->page_cnt; k++)
+    {
+      printf ("Palloc:   order %2d: %4zu free blocks", k, block_cnt[k]);
+      if (free_cnt > 0)
+        printf (", %3zu%% of free pages in smaller blocks",
+                smaller * 100 / free_cnt);
+      printf ("\n");
+      smaller += block_cnt[k] << k;
+    }
+}
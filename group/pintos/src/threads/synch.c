@@ -31,9 +31,32 @@
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
-
-static int _sema_up (struct semaphore *);
-static void lock_remove(struct lock *lock);
+#ifdef LOCK_PROFILE
+#include "threads/tsc.h"
+
+/* synch.h turns lock_init() calls into lock_init_stats() calls,
+   but the function itself is defined here. */
+#undef lock_init
+
+static void lock_profile_acquired (struct lock *, uint64_t start,
+                                   bool contended);
+static void lock_profile_released (struct lock *);
+#endif
+
+static void wait_queue_init (struct heap *);
+static void wait_queue_push (struct heap *, struct thread *);
+static struct thread *wait_queue_pop (struct heap *);
+static heap_action_func refresh_waiter;
+static void yield_to (int priority);
+static void lock_wake (struct lock *);
+static int lock_donation (const struct lock *);
+static heap_less_func lock_donation_more;
+static void donate (struct lock *);
+static void donate_to (struct thread *);
+static void donate_to_readers (struct rwlock *);
+static int effective_priority (const struct thread *);
+static struct rwlock_hold *find_read_hold (struct thread *,
+                                           const struct rwlock *);
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -50,7 +73,7 @@ sema_init (struct semaphore *sema, unsigned value)
   ASSERT (sema != NULL);
 
   sema->value = value;
-  list_init (&sema->waiters);
+  wait_queue_init (&sema->waiters);
 }
 
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
@@ -71,7 +94,7 @@ sema_down (struct semaphore *sema)
   old_level = intr_disable ();
   while (sema->value == 0)
     {
-      list_push_back (&sema->waiters, &thread_current ()->elem);
+      wait_queue_push (&sema->waiters, thread_current ());
       thread_block ();
     }
   sema->value--;
@@ -104,32 +127,37 @@ sema_try_down (struct semaphore *sema)
   return success;
 }
 
-static int
-_sema_up (struct semaphore *sema) {
+/* Up or "V" operation on a semaphore.  Increments SEMA's value
+   and wakes up the highest-priority thread of those waiting for
+   SEMA, if any.
 
-  ASSERT (sema != NULL);
-  
+   This function may be called from an interrupt handler. */
+void
+sema_up (struct semaphore *sema)
+{
   enum intr_level old_level;
+  int priority = -1;
+
+  ASSERT (sema != NULL);
+
   old_level = intr_disable ();
-  int rval = -1;
-  if (!list_empty (&sema->waiters)) {
-    struct thread *t = thread_with_highest_priority_in_list (&sema->waiters);
-	list_remove (&t->elem);
-    thread_unblock (t);
-	rval = t->priority;
-  }
+  if (!heap_empty (&sema->waiters))
+    {
+      struct thread *t = wait_queue_pop (&sema->waiters);
+      thread_unblock (t);
+      priority = t->priority;
+    }
   sema->value++;
   intr_set_level (old_level);
-  return rval;
+
+  yield_to (priority);
 }
-/* Up or "V" operation on a semaphore.  Increments SEMA's value
-   and wakes up one thread of those waiting for SEMA, if any.
 
-   This function may be called from an interrupt handler. */
-void
-sema_up (struct semaphore *sema)
+/* Yields the CPU if a thread with PRIORITY was just woken up and
+   should preempt the running thread. */
+static void
+yield_to (int priority)
 {
-  int priority = _sema_up (sema);
   /* 之所以有这一个判断, 因为thread_exit可能会调用sema_up */
   if (thread_status() != THREAD_RUNNING)
     return;
@@ -204,6 +232,9 @@ lock_init (struct lock *lock)
 
   lock->holder = NULL;
   sema_init (&lock->semaphore, 1);
+#ifdef LOCK_PROFILE
+  lock->stats = NULL;
+#endif
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -221,38 +252,38 @@ lock_acquire (struct lock *lock)
   ASSERT (!intr_context ());
   ASSERT (!lock_held_by_current_thread (lock));
 
+  struct thread *t = thread_current ();
   enum intr_level old_level = intr_disable ();
-  /* priority donation 
-   * t依赖t1解锁, t1依赖t2解锁, t2依赖t3解锁....直到tn
-   * 所以可能需要把t的priority赋给t1-tn*/
-  if (!thread_mlfqs) {
-
-    if (lock->holder) {
-	  struct thread *t = thread_current ();
-	  struct thread *holder = lock->holder;
-	  if (t->priority > holder->priority) {
-	    holder->priority = t->priority;
-	    while (holder->status == THREAD_BLOCKED) {
-		  if (!holder->lock_wanted) {
-             break;
-		  }
-          if (t->priority > holder->lock_wanted->holder->priority) {
-		    holder->lock_wanted->holder->priority = t->priority;
-		    holder = holder->lock_wanted->holder;
-		  }
-	    }
-	  }
+#ifdef LOCK_PROFILE
+  uint64_t start = rdtsc ();
+  bool contended = lock->semaphore.value == 0;
+#endif
+  while (lock->semaphore.value == 0)
+    {
+      wait_queue_push (&lock->semaphore.waiters, t);
+      /* priority donation
+       * t依赖t1解锁, t1依赖t2解锁, t2依赖t3解锁....直到tn
+       * 所以可能需要把t的priority赋给t1-tn*/
+      if (!thread_mlfqs)
+        {
+          t->lock_wanted = lock;
+          donate (lock);
+        }
+      thread_block ();
     }
+  lock->semaphore.value--;
+  t->lock_wanted = NULL;
+  lock->holder = t;
+  if (!thread_mlfqs)
+    {
+      heap_insert (&t->locks, &lock->elem);
 
-    thread_current ()->lock_wanted = lock;
-  }
-  /* end priority donation */
-
-  sema_down (&lock->semaphore);
-
-  lock->holder = thread_current ();
-  thread_current ()->lock_wanted = NULL;
-  list_push_back (&lock->holder->locks, &lock->elem);
+      /* Threads still waiting for LOCK now donate to us. */
+      donate (lock);
+    }
+#ifdef LOCK_PROFILE
+  lock_profile_acquired (lock, start, contended);
+#endif
   intr_set_level (old_level);
 }
 
@@ -265,14 +296,31 @@ lock_acquire (struct lock *lock)
 bool
 lock_try_acquire (struct lock *lock)
 {
+  enum intr_level old_level;
   bool success;
 
   ASSERT (lock != NULL);
   ASSERT (!lock_held_by_current_thread (lock));
 
+  old_level = intr_disable ();
   success = sema_try_down (&lock->semaphore);
   if (success)
-    lock->holder = thread_current ();
+    {
+      lock->holder = thread_current ();
+      if (!thread_mlfqs)
+        {
+          heap_insert (&lock->holder->locks, &lock->elem);
+          donate (lock);
+        }
+#ifdef LOCK_PROFILE
+      lock_profile_acquired (lock, rdtsc (), false);
+#endif
+    }
+#ifdef LOCK_PROFILE
+  else if (lock->stats != NULL)
+    lock->stats->contended++;
+#endif
+  intr_set_level (old_level);
   return success;
 }
 
@@ -284,37 +332,157 @@ lock_try_acquire (struct lock *lock)
 void
 lock_release (struct lock *lock)
 {
+  enum intr_level old_level;
+
   ASSERT (lock != NULL);
   ASSERT (lock_held_by_current_thread (lock));
-  /* 这段代码是否需要像lock_acquire那样全部在关中断后运行？
-   * 似乎不要, lock_acquire如果不在一开始就关中断，特定情况有可能死循环
-   */
-  lock_remove (lock);
+
+  old_level = intr_disable ();
+  lock_wake (lock);
+  intr_set_level (old_level);
+
+  thread_set_priority_tail (thread_current ()->priority);
+}
+
+/* Releases LOCK, which must be owned by the current thread, and
+   wakes up its highest-priority waiter without yielding the CPU.
+   Interrupts must be off. */
+static void
+lock_wake (struct lock *lock)
+{
+  struct thread *t = thread_current ();
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+#ifdef LOCK_PROFILE
+  lock_profile_released (lock);
+#endif
   lock->holder = NULL;
-  if (thread_mlfqs)
-	sema_up (&lock->semaphore);
-  else {
-    _sema_up (&lock->semaphore);
-  
-    struct thread *t = thread_current ();
-    int priority_should_set = t->original_priority;
-    
-    /* 此时线程可能还持有其他锁，这些锁也可能有相应的等待者，等待者之中
-     * 取优先级最高的与original_priority比较，将更大的值赋给t->priority */
-    struct list_elem *e;
-    for (e = list_begin (&t->locks); e != list_end (&t->locks); e = list_next (e)) {
-	  struct lock *lock1 = list_entry (e, struct lock, elem);
-	  struct list *waiters = &lock1->semaphore.waiters;
-          if (!list_empty (waiters)) {
-            int priority = thread_with_highest_priority_in_list (waiters)->priority;
-            priority_should_set = priority > priority_should_set ? priority : priority_should_set;
-	  }	  
+  if (!thread_mlfqs)
+    {
+      /* 此时线程可能还持有其他锁，这些锁也可能有相应的等待者，等待者之中
+       * 取优先级最高的与original_priority比较，将更大的值赋给t->priority */
+      heap_remove (&t->locks, &lock->elem);
+      t->priority = effective_priority (t);
     }
-    t->priority = priority_should_set;
-    thread_set_priority_tail (priority_should_set);
-  }
+
+  if (!heap_empty (&lock->semaphore.waiters))
+    thread_unblock (wait_queue_pop (&lock->semaphore.waiters));
+  lock->semaphore.value++;
 }
 
+#ifdef LOCK_PROFILE
+/* List of the statistics of every lock_init() call site that has
+   initialized a lock. */
+static struct lock_stats *all_lock_stats;
+
+/* Initializes LOCK, like lock_init(), and records its contention
+   statistics in STATS. */
+void
+lock_init_stats (struct lock *lock, struct lock_stats *stats)
+{
+  enum intr_level old_level;
+
+  ASSERT (stats != NULL);
+
+  lock_init (lock);
+  lock->stats = stats;
+
+  old_level = intr_disable ();
+  if (!stats->registered)
+    {
+      stats->registered = true;
+      stats->next = all_lock_stats;
+      all_lock_stats = stats;
+    }
+  intr_set_level (old_level);
+}
+
+/* Records that the current thread acquired LOCK after starting
+   to wait for it at time START.  CONTENDED tells whether the
+   lock was held when it tried.  Interrupts must be off. */
+static void
+lock_profile_acquired (struct lock *lock, uint64_t start, bool contended)
+{
+  struct lock_stats *s = lock->stats;
+  uint64_t now = rdtsc ();
+
+  lock->acquire_time = now;
+  if (s == NULL)
+    return;
+
+  s->acquired++;
+  if (contended)
+    {
+      uint64_t wait = now - start;
+
+      s->contended++;
+      s->total_wait += wait;
+      if (wait > s->max_wait)
+        s->max_wait = wait;
+    }
+}
+
+/* Records that LOCK is being released.  Interrupts must be
+   off. */
+static void
+lock_profile_released (struct lock *lock)
+{
+  struct lock_stats *s = lock->stats;
+
+  if (s != NULL)
+    {
+      uint64_t hold = rdtsc () - lock->acquire_time;
+      if (hold > s->max_hold)
+        s->max_hold = hold;
+    }
+}
+
+/* Prints lock contention statistics, most waited-for locks
+   first. */
+void
+lock_print_stats (void)
+{
+  struct lock_stats *sorted = NULL;
+  struct lock_stats *s, *next, **p;
+  enum intr_level old_level;
+
+  /* Insertion sort by total wait time, then by contention. */
+  old_level = intr_disable ();
+  for (s = all_lock_stats; s != NULL; s = next)
+    {
+      next = s->next;
+      for (p = &sorted; *p != NULL; p = &(*p)->next)
+        if (s->total_wait > (*p)->total_wait
+            || (s->total_wait == (*p)->total_wait
+                && s->contended > (*p)->contended))
+          break;
+      s->next = *p;
+      *p = s;
+    }
+  all_lock_stats = sorted;
+  intr_set_level (old_level);
+
+  printf ("Locks: contention in CPU cycles, most waited for first\n");
+  printf ("  %-36s %9s %9s %12s %11s %11s\n", "lock", "acquired",
+          "contended", "total wait", "max wait", "max hold");
+  for (s = sorted; s != NULL; s = s->next)
+    {
+      const char *file = s->file;
+      char name[64];
+
+      if (s->acquired == 0 && s->contended == 0)
+        continue;
+      while (file[0] == '.' && file[1] == '.' && file[2] == '/')
+        file += 3;
+      snprintf (name, sizeof name, "%s (%s:%d)", s->name, file, s->line);
+      printf ("  %-36s %9llu %9llu %12llu %11llu %11llu\n",
+              name, s->acquired, s->contended, s->total_wait,
+              s->max_wait, s->max_hold);
+    }
+}
+#endif /* LOCK_PROFILE */
+
 /* Returns true if the current thread holds LOCK, false
    otherwise.  (Note that testing whether some other thread holds
    a lock would be racy.) */
@@ -326,12 +494,40 @@ lock_held_by_current_thread (const struct lock *lock)
   return lock->holder == thread_current ();
 }
 
-/* One semaphore in a list. */
-struct semaphore_elem
-  {
-    struct list_elem elem;              /* List element. */
-    struct semaphore semaphore;         /* This semaphore. */
-  };
+/* Initializes HELD, a thread's heap of held locks, so that the
+   lock whose waiters donate the highest priority comes out
+   first. */
+void
+held_locks_init (struct heap *held)
+{
+  heap_init (held, lock_donation_more, NULL);
+}
+
+/* Returns the highest priority donated to T by the threads
+   waiting for the locks it holds, or PRI_MIN if there are
+   none. */
+int
+donated_priority (const struct thread *t)
+{
+  struct heap_elem *e = heap_min (&t->locks);
+  int priority = PRI_MIN;
+  int i;
+
+  if (e != NULL)
+    priority = lock_donation (heap_entry (e, struct lock, elem));
+
+  /* A writer waiting for a readers-writer lock that T holds for
+     reading holds the lock's inner lock. */
+  for (i = 0; i < RWLOCK_READ_MAX; i++)
+    {
+      struct rwlock *rw = t->read_holds[i].rwlock;
+      if (rw != NULL && rw->lock.holder != NULL
+          && rw->lock.holder->rwlock_wanted == rw
+          && rw->lock.holder->priority > priority)
+        priority = rw->lock.holder->priority;
+    }
+  return priority;
+}
 
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
@@ -341,7 +537,7 @@ cond_init (struct condition *cond)
 {
   ASSERT (cond != NULL);
 
-  list_init (&cond->waiters);
+  wait_queue_init (&cond->waiters);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -367,17 +563,21 @@ cond_init (struct condition *cond)
 void
 cond_wait (struct condition *cond, struct lock *lock)
 {
-  struct semaphore_elem waiter;
+  enum intr_level old_level;
 
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (lock_held_by_current_thread (lock));
 
-  sema_init (&waiter.semaphore, 0);
-  list_push_back (&cond->waiters, &waiter.elem);
-  lock_release (lock);
-  sema_down (&waiter.semaphore);
+  /* Join the queue before releasing LOCK, and do not yield in
+     between, so that a signal cannot slip past us. */
+  old_level = intr_disable ();
+  wait_queue_push (&cond->waiters, thread_current ());
+  lock_wake (lock);
+  thread_block ();
+  intr_set_level (old_level);
+
   lock_acquire (lock);
 }
 
@@ -391,23 +591,24 @@ cond_wait (struct condition *cond, struct lock *lock)
 void
 cond_signal (struct condition *cond, struct lock *lock UNUSED)
 {
+  enum intr_level old_level;
+  int priority = -1;
+
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
   ASSERT (!intr_context ());
   ASSERT (lock_held_by_current_thread (lock));
 
-  if (!list_empty (&cond->waiters)) {
-	struct semaphore_elem *sema_elem = list_entry (list_begin (&cond->waiters), struct semaphore_elem, elem);
-	struct list_elem *e;
-	for (e = list_next (list_begin (&cond->waiters)); e != list_end (&cond->waiters); e = list_next (e)) {
-	   struct semaphore_elem *s_elem = list_entry (e, struct semaphore_elem, elem);
-	   struct thread *t = list_entry (list_begin (&s_elem->semaphore.waiters), struct thread, elem);
-	   if (t->priority > list_entry (list_begin (&sema_elem->semaphore.waiters), struct thread, elem)->priority)
-		 sema_elem = s_elem; 
-	}
-    list_remove (&sema_elem->elem);
-    sema_up (&sema_elem->semaphore);
-  }
+  old_level = intr_disable ();
+  if (!heap_empty (&cond->waiters))
+    {
+      struct thread *t = wait_queue_pop (&cond->waiters);
+      thread_unblock (t);
+      priority = t->priority;
+    }
+  intr_set_level (old_level);
+
+  yield_to (priority);
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -422,12 +623,271 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   ASSERT (cond != NULL);
   ASSERT (lock != NULL);
 
-  while (!list_empty (&cond->waiters))
+  while (!heap_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
 
+/* Initializes readers-writer lock RW. */
+void
+rwlock_init (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_init (&rw->lock);
+  list_init (&rw->readers);
+  sema_init (&rw->drained, 0);
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or
+   is waiting for it.  The current thread must not already hold
+   RW.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_read (struct rwlock *rw)
+{
+  struct thread *t = thread_current ();
+  struct rwlock_hold *h;
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (find_read_hold (t, rw) == NULL);
+
+  /* Readers pass through RW's inner lock, so they line up behind
+     a writer that holds it, and donate to it while they wait. */
+  lock_acquire (&rw->lock);
+  old_level = intr_disable ();
+  h = find_read_hold (t, NULL);
+  ASSERT (h != NULL);
+  h->rwlock = rw;
+  h->thread = t;
+  list_push_back (&rw->readers, &h->elem);
+  intr_set_level (old_level);
+  lock_release (&rw->lock);
+}
+
+/* Releases RW, which the current thread must hold for reading.
+   If it was the last reader and a writer is waiting, wakes the
+   writer. */
+void
+rwlock_release_read (struct rwlock *rw)
+{
+  struct thread *t = thread_current ();
+  struct rwlock_hold *h;
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+
+  old_level = intr_disable ();
+  h = find_read_hold (t, rw);
+  ASSERT (h != NULL);
+  list_remove (&h->elem);
+  h->rwlock = NULL;
+
+  /* Give back the writer's donation, if any, before waking it,
+     so that it preempts us if it should. */
+  if (!thread_mlfqs)
+    t->priority = effective_priority (t);
+  if (list_empty (&rw->readers) && !heap_empty (&rw->drained.waiters))
+    sema_up (&rw->drained);
+  intr_set_level (old_level);
+
+  thread_set_priority_tail (t->priority);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.  The current thread must not already hold RW.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw)
+{
+  struct thread *t = thread_current ();
+  enum intr_level old_level;
+
+  ASSERT (rw != NULL);
+  ASSERT (!intr_context ());
+  ASSERT (find_read_hold (t, rw) == NULL);
+
+  /* Holding the inner lock keeps out other writers and new
+     readers.  Then wait for the readers already inside. */
+  lock_acquire (&rw->lock);
+  old_level = intr_disable ();
+  while (!list_empty (&rw->readers))
+    {
+      if (!thread_mlfqs)
+        {
+          t->rwlock_wanted = rw;
+          donate_to_readers (rw);
+        }
+      sema_down (&rw->drained);
+    }
+  t->rwlock_wanted = NULL;
+  intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for
+   writing. */
+void
+rwlock_release_write (struct rwlock *rw)
+{
+  ASSERT (rw != NULL);
+
+  lock_release (&rw->lock);
+}
+
+/* Returns T's hold on RW for reading, or a null pointer if T
+   does not hold RW for reading.  If RW is null, returns an
+   unused hold instead. */
+static struct rwlock_hold *
+find_read_hold (struct thread *t, const struct rwlock *rw)
+{
+  int i;
+
+  for (i = 0; i < RWLOCK_READ_MAX; i++)
+    if (t->read_holds[i].rwlock == rw)
+      return &t->read_holds[i];
+  return NULL;
+}
+
+/* Returns true if thread A, in a wait queue, has a higher
+   priority than thread B. */
+static bool
+waiter_more (const struct heap_elem *a_, const struct heap_elem *b_,
+             void *aux UNUSED)
+{
+  const struct thread *a = heap_entry (a_, struct thread, wait_elem);
+  const struct thread *b = heap_entry (b_, struct thread, wait_elem);
+
+  return a->priority > b->priority;
+}
+
+/* Initializes Q as an empty wait queue. */
+static void
+wait_queue_init (struct heap *q)
+{
+  heap_init (q, waiter_more, NULL);
+}
+
+/* Adds T to wait queue Q.  Interrupts must be off. */
+static void
+wait_queue_push (struct heap *q, struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  heap_insert (q, &t->wait_elem);
+  t->wait_queue = q;
+}
+
+/* Removes and returns the highest-priority thread in Q, which
+   must not be empty.  Among threads of equal priority, the one
+   that has waited longest comes first.  Interrupts must be
+   off.
+
+   The MLFQS lets the priorities of blocked threads fall behind,
+   so they are brought up to date first. */
+static struct thread *
+wait_queue_pop (struct heap *q)
+{
+  struct thread *t;
+
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (thread_mlfqs)
+    heap_update_all (q, refresh_waiter, NULL);
+  t = heap_entry (heap_pop_min (q), struct thread, wait_elem);
+  t->wait_queue = NULL;
+  return t;
+}
+
+/* Brings the priority of the thread waiting in E up to date, for
+   wait_queue_pop(). */
+static void
+refresh_waiter (struct heap_elem *e, void *aux UNUSED)
+{
+  thread_mlfqs_refresh (heap_entry (e, struct thread, wait_elem));
+}
+
+/* Returns the priority that LOCK's waiters donate to its holder,
+   which is that of the highest-priority waiter, or PRI_MIN if
+   there are no waiters. */
+static int
+lock_donation (const struct lock *lock)
+{
+  struct heap_elem *e = heap_min (&lock->semaphore.waiters);
+  return e != NULL ? heap_entry (e, struct thread, wait_elem)->priority : PRI_MIN;
+}
+
+/* Returns true if the waiters for lock A donate a higher
+   priority than those for lock B. */
+static bool
+lock_donation_more (const struct heap_elem *a, const struct heap_elem *b,
+                    void *aux UNUSED)
+{
+  return (lock_donation (heap_entry (a, struct lock, elem))
+          > lock_donation (heap_entry (b, struct lock, elem)));
+}
+
+/* Returns the priority that T should run at: its own, or the
+   highest one donated to it if that is higher. */
+static int
+effective_priority (const struct thread *t)
+{
+  int donated = donated_priority (t);
+  return t->original_priority > donated ? t->original_priority : donated;
+}
+
+/* Called after the set of threads waiting for LOCK, or the
+   priority of one of them, has changed.  Recomputes the priority
+   of LOCK's holder and, if it changed, of the holder of the lock
+   that the holder is waiting for, and so on down the chain.
+   Each step takes logarithmic time in the number of locks held
+   and threads waiting, instead of rescanning them.  Interrupts
+   must be off. */
 static void
-lock_remove (struct lock *lock)
+donate (struct lock *lock)
 {
-  list_remove (&(lock->elem));
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  if (lock->holder != NULL)
+    {
+      heap_update (&lock->holder->locks, &lock->elem);
+      donate_to (lock->holder);
+    }
+}
+
+/* Recomputes the priority of T after a donation to it may have
+   changed and, if it did change, passes the change on to
+   whichever threads T is waiting for.  Interrupts must be off. */
+static void
+donate_to (struct thread *t)
+{
+  int priority = effective_priority (t);
+
+  if (priority == t->priority)
+    return;
+  thread_update_priority (t, priority);
+  if (t->lock_wanted != NULL)
+    donate (t->lock_wanted);
+  else if (t->rwlock_wanted != NULL)
+    donate_to_readers (t->rwlock_wanted);
+}
+
+/* Recomputes the priorities of the threads holding RW for
+   reading after the priority of the writer waiting for them may
+   have changed.  Interrupts must be off. */
+static void
+donate_to_readers (struct rwlock *rw)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&rw->readers); e != list_end (&rw->readers);
+       e = list_next (e))
+    {
+      struct rwlock_hold *h = list_entry (e, struct rwlock_hold, elem);
+      donate_to (h->thread);
+    }
 }
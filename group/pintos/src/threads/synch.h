@@ -1,14 +1,17 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore
   {
     unsigned value;             /* Current value. */
-    struct list waiters;        /* List of waiting threads. */
+    struct heap waiters;        /* Waiting threads, highest priority
+                                   first. */
   };
 
 void sema_init (struct semaphore *, unsigned value);
@@ -22,7 +25,11 @@ struct lock
   {
     struct thread *holder;      /* Thread holding lock (for debugging). */
     struct semaphore semaphore; /* Binary semaphore controlling access. */
-	struct list_elem elem;
+    struct heap_elem elem;      /* Element in holder's `locks' heap. */
+#ifdef LOCK_PROFILE
+    struct lock_stats *stats;   /* Statistics for this lock, or null. */
+    uint64_t acquire_time;      /* TSC when the holder acquired it. */
+#endif
   };
 
 void lock_init (struct lock *);
@@ -31,10 +38,53 @@ bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
+#ifdef LOCK_PROFILE
+/* Lock contention statistics.
+
+   All the locks initialized by the same lock_init() call share
+   one of these, so that, for example, the locks of all the
+   malloc() descriptors are reported together under the name
+   "&d->lock".  Times are in CPU cycles as counted by the time
+   stamp counter. */
+struct lock_stats
+  {
+    const char *name;           /* Argument to lock_init(). */
+    const char *file;           /* Source file of lock_init() call. */
+    int line;                   /* Line of lock_init() call. */
+    struct lock_stats *next;    /* Next in list of all statistics. */
+    bool registered;            /* On the list yet? */
+
+    unsigned long long acquired;  /* # of successful acquisitions. */
+    unsigned long long contended; /* # of times the lock was held. */
+    uint64_t total_wait;        /* Total cycles spent waiting. */
+    uint64_t max_wait;          /* Longest wait. */
+    uint64_t max_hold;          /* Longest time held. */
+  };
+
+void lock_init_stats (struct lock *, struct lock_stats *);
+void lock_print_stats (void);
+
+/* Gives each lock_init() call site its own statistics. */
+#define lock_init(LOCK)                                         \
+        do                                                      \
+          {                                                     \
+            static struct lock_stats lock_stats_ =              \
+              { #LOCK, __FILE__, __LINE__, NULL, false,         \
+                0, 0, 0, 0, 0 };                                \
+            lock_init_stats ((LOCK), &lock_stats_);             \
+          }                                                     \
+        while (0)
+#endif
+
+/* Priority donation. */
+void held_locks_init (struct heap *);
+int donated_priority (const struct thread *);
+
 /* Condition variable. */
 struct condition
   {
-    struct list waiters;        /* List of waiting threads. */
+    struct heap waiters;        /* Waiting threads, highest priority
+                                   first. */
   };
 
 void cond_init (struct condition *);
@@ -42,6 +92,43 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Readers-writer lock.
+
+   Any number of readers may hold the lock at once, or a single
+   writer.  Writers are preferred: once a writer is waiting, new
+   readers wait behind it, so a steady stream of readers cannot
+   starve writers.  Otherwise waiting readers and writers are
+   served in priority order, first come first served within a
+   priority, so writers cannot starve readers either.  Readers
+   waiting for a writer donate their priority to it, and a writer
+   waiting for readers donates its priority to all of them.
+
+   A thread may hold at most RWLOCK_READ_MAX readers-writer locks
+   for reading at a time, and none of them recursively. */
+#define RWLOCK_READ_MAX 4
+
+struct rwlock
+  {
+    struct lock lock;           /* Held by the writer, and briefly by
+                                   readers on their way in. */
+    struct list readers;        /* Read holds, as struct rwlock_hold. */
+    struct semaphore drained;   /* Writer waits here for readers. */
+  };
+
+/* A thread's hold on a readers-writer lock for reading. */
+struct rwlock_hold
+  {
+    struct rwlock *rwlock;      /* Lock held, or null if unused. */
+    struct thread *thread;      /* Thread holding it. */
+    struct list_elem elem;      /* Element in rwlock's `readers'. */
+  };
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
@@ -49,4 +136,70 @@ void cond_broadcast (struct condition *, struct lock *);
    reference guide for more information.*/
 #define barrier() asm volatile ("" : : : "memory")
 
+/* Sequence lock.
+
+   Protects small, frequently read data that a writer updates in
+   a few instructions, such as a 64-bit counter, without making
+   readers lock anything or disable interrupts.  A reader copies
+   the data and tries again if a writer was active meanwhile:
+
+      unsigned seq;
+      do
+        {
+          seq = seqlock_read_begin (&sl);
+          copy = data;
+        }
+      while (seqlock_read_retry (&sl, seq));
+
+   Writers must have interrupts off, so that no reader can run
+   in the middle of a write on the same CPU. */
+struct seqlock
+  {
+    volatile unsigned seq;      /* Odd while a write is in progress. */
+  };
+
+/* Initializes SL. */
+static inline void
+seqlock_init (struct seqlock *sl)
+{
+  sl->seq = 0;
+}
+
+/* Starts reading data protected by SL.  Returns a value to pass
+   to seqlock_read_retry(). */
+static inline unsigned
+seqlock_read_begin (const struct seqlock *sl)
+{
+  unsigned seq = sl->seq;
+  barrier ();
+  return seq;
+}
+
+/* Returns true if the data protected by SL that was read since
+   the seqlock_read_begin() call that returned SEQ may be
+   inconsistent and must be read again. */
+static inline bool
+seqlock_read_retry (const struct seqlock *sl, unsigned seq)
+{
+  barrier ();
+  return (seq & 1) != 0 || sl->seq != seq;
+}
+
+/* Starts writing data protected by SL.  Interrupts must be
+   off. */
+static inline void
+seqlock_write_begin (struct seqlock *sl)
+{
+  sl->seq++;
+  barrier ();
+}
+
+/* Finishes writing data protected by SL. */
+static inline void
+seqlock_write_end (struct seqlock *sl)
+{
+  barrier ();
+  sl->seq++;
+}
+
 #endif /* threads/synch.h */
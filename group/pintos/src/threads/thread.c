@@ -10,6 +10,7 @@
 #include "threads/palloc.h"
 #include "threads/switch.h"
 #include "threads/synch.h"
+#include "threads/tsc.h"
 #include "threads/vaddr.h"
 #include "threads/malloc.h"
 #include "../devices/timer.h"
@@ -18,6 +19,7 @@
 #endif
 #ifdef FILESYS
 #include "filesys/file.h"
+#include "userprog/fdtable.h"
 #endif
 
 /* Random value for struct thread's `magic' member.
@@ -25,26 +27,33 @@
    of thread.h for details. */
 #define THREAD_MAGIC 0xcd6abf4b
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Pages of exited threads kept for new threads. */
+#define THREAD_PAGE_CACHE_SIZE 16
 
-/* used by mlfqs */
+/* Run queue of processes in THREAD_READY state, that is,
+   processes that are ready to run but not actually running.
+   There is one FIFO list per priority, shared by the priority
+   scheduler and the MLFQS.  Bit P of ready_mask is set if and
+   only if ready_lists[P] is nonempty, so finding the highest
+   ready priority is a single bit scan. */
 static struct list ready_lists[PRI_MAX+1];
+static uint64_t ready_mask;
+static int nr_ready;            /* # of threads in ready_lists[]. */
+
+/* Idle thread. */
+static struct thread *idle_thread;
+
+/* Pages of exited threads, kept for reuse. */
+static struct thread *page_cache[THREAD_PAGE_CACHE_SIZE];
+static int page_cache_cnt;      /* # of pages in page_cache[]. */
 
 /* List of all processes.  Processes are added to this list
    when they are first scheduled and removed when they exit. */
 static struct list all_list;
 
-/* Idle thread. */
-static struct thread *idle_thread;
-
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
-/* Lock used by allocate_tid(). */
-static struct lock tid_lock;
-
 /* Stack frame for kernel_thread(). */
 struct kernel_thread_frame
   {
@@ -57,6 +66,7 @@ struct kernel_thread_frame
 static long long idle_ticks;    /* # of timer ticks spent idle. */
 static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
 static long long user_ticks;    /* # of timer ticks in user programs. */
+static struct sched_stats sched_totals; /* See thread_get_sched_stats(). */
 
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
@@ -67,11 +77,52 @@ static unsigned thread_ticks;   /* # of timer ticks since last yield. */
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If true, reuse the pages of exited threads.  See thread.h. */
+bool thread_cache_pages = true;
+
 static fixed_point_t load_avg;
 static int ready_threads = 0;
+
+/* MLFQS bookkeeping.  Instead of recomputing every thread's
+   recent_cpu and priority from the timer interrupt, the MLFQS
+   only updates the threads whose inputs have changed:
+
+     - Every 4 ticks, the threads that ran since the last time
+       (the "dirty" threads) get their priority recomputed.
+
+     - Every second, recent_cpu decays in every thread.  Running
+       and ready threads are decayed at once, because their
+       priority decides what runs next.  Blocked threads wait on
+       stale_list and are decayed when they are unblocked, by
+       replaying each decay they missed from decay_coeff[].  A
+       wait queue also brings its waiters up to date before it
+       chooses one to wake, through thread_mlfqs_refresh().
+
+   A thread that stays blocked for DECAY_HISTORY seconds is
+   caught up before its oldest coefficient is overwritten.
+   stale_list is ordered by decay_epoch, so this only ever looks
+   at the front of the list.
+
+   The results are exactly the same as recomputing everything:
+   a thread's priority only changes when its recent_cpu or nice
+   does. */
+#define DECAY_HISTORY 64
+static struct list dirty_list;  /* Threads that ran since the last update. */
+static struct list stale_list;  /* Blocked threads, oldest decay first. */
+static unsigned decay_epoch;    /* Number of recent_cpu decays so far. */
+static fixed_point_t decay_coeff[DECAY_HISTORY];
+
+/* Constant factors of the load_avg formula. */
+static fixed_point_t load_avg_coeff;    /* 59/60. */
+static fixed_point_t ready_coeff;       /* 1/60. */
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
+static struct thread *alloc_thread_page (void);
+static void sched_account (struct thread *cur, struct thread *next);
+static void sched_hist_add (struct sched_hist *, uint64_t cycles);
+static void print_sched_hist (const char *name, const struct sched_hist *);
+static void print_thread_sched (struct thread *, void *aux);
 static struct thread *running_thread (void);
 static struct thread *next_thread_to_run (void);
 static void init_thread (struct thread *, const char *name, int priority);
@@ -81,12 +132,18 @@ static void schedule (void);
 void thread_schedule_tail (struct thread *prev);
 static tid_t allocate_tid (void);
 
-static void recompute_all_threads_priority (void);
-static void recompute_all_threads_recent_cpu (void);
+static void mlfqs_start_decay (void);
+static void mlfqs_update_priorities (bool decayed);
+static void mlfqs_update_thread (struct thread *, struct list *movers);
+static void mlfqs_catch_up (struct thread *);
+static void mlfqs_decay (struct thread *);
+static bool tid_less (const struct list_elem *, const struct list_elem *,
+                      void *);
 static int compute_priority (int, fixed_point_t);
 static fixed_point_t recompute_load_avg (fixed_point_t);
-static fixed_point_t recompute_recent_cpu (fixed_point_t, fixed_point_t, int);
 
+static void ready_queue_push (struct thread *);
+static void ready_queue_remove (struct thread *);
 static int highest_priority_in_ready_lists (void);
 
 /* Initializes the threading system by transforming the code
@@ -107,17 +164,17 @@ thread_init (void)
 {
   ASSERT (intr_get_level () == INTR_OFF);
 
-  lock_init (&tid_lock);
-  if (!thread_mlfqs)
-    list_init (&ready_list);
-  else {
-	int i;
-	for (i = PRI_MIN; i < PRI_MAX+1; i++)
-	   list_init (&ready_lists[i]);
-  }
+  int i;
+  for (i = PRI_MIN; i < PRI_MAX+1; i++)
+    list_init (&ready_lists[i]);
+  ready_mask = 0;
   list_init (&all_list);
+  list_init (&dirty_list);
+  list_init (&stale_list);
   
   load_avg = fix_int (0);
+  load_avg_coeff = fix_frac (59, 60);
+  ready_coeff = fix_frac (1, 60);
   /* Set up a thread structure for the running thread. */
   initial_thread = running_thread ();
   init_thread (initial_thread, "main", PRI_DEFAULT);
@@ -164,6 +221,14 @@ thread_tick (void)
   else
     kernel_ticks++;
 
+  /* Sample the run queue length. */
+  sched_totals.rq_samples++;
+  sched_totals.rq_total += nr_ready;
+  sched_totals.rq_count[nr_ready < SCHED_RQ_BUCKETS
+                        ? nr_ready : SCHED_RQ_BUCKETS - 1]++;
+  if (nr_ready > sched_totals.rq_max)
+    sched_totals.rq_max = nr_ready;
+
   /* Enforce preemption. */
   if (++thread_ticks >= TIME_SLICE)
     intr_yield_on_return ();
@@ -171,12 +236,18 @@ thread_tick (void)
   if (!thread_mlfqs) return;
 
   t->recent_cpu= fix_add (t->recent_cpu, fix_int (1));
+  if (!t->mlfqs_dirty) {
+    t->mlfqs_dirty = true;
+    list_push_back (&dirty_list, &t->dirty_elem);
+  }
+  bool decayed = false;
   if ((kernel_ticks+idle_ticks) % TIMER_FREQ == 0) {
     load_avg = recompute_load_avg (load_avg);
-    recompute_all_threads_recent_cpu ();	
+    mlfqs_start_decay ();
+    decayed = true;
   }
   if ((kernel_ticks+idle_ticks) % 4 == 0) {
-    recompute_all_threads_priority ();
+    mlfqs_update_priorities (decayed);
 	if (t->priority < highest_priority_in_ready_lists ())
 	  intr_yield_on_return ();
   }
@@ -186,8 +257,83 @@ thread_tick (void)
 void
 thread_print_stats (void)
 {
+  const struct sched_stats *s = &sched_totals;
+  enum intr_level old_level;
+
   printf ("Thread: %lld idle ticks, %lld kernel ticks, %lld user ticks\n",
           idle_ticks, kernel_ticks, user_ticks);
+  printf ("Thread: %llu voluntary, %llu involuntary context switches\n",
+          s->voluntary, s->involuntary);
+  print_sched_hist ("wake-up latency", &s->wake_latency);
+  print_sched_hist ("time slice", &s->slice);
+  if (s->rq_samples > 0)
+    {
+      unsigned long long hundredths = s->rq_total * 100 / s->rq_samples;
+      int i;
+
+      printf ("Thread: run queue length %llu.%02llu on average, "
+              "%d at most, over %llu ticks\n",
+              hundredths / 100, hundredths % 100, s->rq_max, s->rq_samples);
+      printf ("Thread:  ");
+      for (i = 0; i < SCHED_RQ_BUCKETS; i++)
+        if (s->rq_count[i] != 0)
+          printf (" %d%s:%u", i, i == SCHED_RQ_BUCKETS - 1 ? "+" : "",
+                  s->rq_count[i]);
+      printf ("\n");
+    }
+
+  old_level = intr_disable ();
+  thread_foreach (print_thread_sched, NULL);
+  intr_set_level (old_level);
+}
+
+/* Prints histogram H under the given NAME. */
+static void
+print_sched_hist (const char *name, const struct sched_hist *h)
+{
+  int i;
+
+  printf ("Thread: %s: %u samples", name, h->samples);
+  if (h->samples > 0)
+    printf (", mean %llu, max %llu cycles",
+            (unsigned long long) (h->total / h->samples),
+            (unsigned long long) h->max);
+  printf ("\n");
+  for (i = 0; i < SCHED_HIST_BUCKETS; i++)
+    if (h->count[i] != 0)
+      {
+        if (i == SCHED_HIST_BUCKETS - 1)
+          printf ("Thread:   [2^%d, ...) %u\n", i, h->count[i]);
+        else
+          printf ("Thread:   [2^%d, 2^%d) %u\n", i, i + 1, h->count[i]);
+      }
+}
+
+/* Prints T's scheduler statistics.  For thread_foreach(). */
+static void
+print_thread_sched (struct thread *t, void *aux UNUSED)
+{
+  const struct sched_hist *h = &t->wake_latency;
+
+  if (t == idle_thread)
+    return;
+  printf ("Thread: %s: %u voluntary, %u involuntary switches, "
+          "%u wake-ups", t->name, t->voluntary_switches,
+          t->involuntary_switches, h->samples);
+  if (h->samples > 0)
+    printf (" (latency mean %llu, max %llu cycles)",
+            (unsigned long long) (h->total / h->samples),
+            (unsigned long long) h->max);
+  printf ("\n");
+}
+
+/* Copies the running CPU's scheduler statistics into STATS. */
+void
+thread_get_sched_stats (struct sched_stats *stats)
+{
+  enum intr_level old_level = intr_disable ();
+  *stats = sched_totals;
+  intr_set_level (old_level);
 }
 
 /* Creates a new kernel thread named NAME with the given initial
@@ -214,13 +360,28 @@ thread_create (const char *name, int priority,
   struct switch_entry_frame *ef;
   struct switch_threads_frame *sf;
   tid_t tid;
+#ifdef FILESYS
+  struct fd_table *fd_table;
+#endif
 
   ASSERT (function != NULL);
 
+#ifdef FILESYS
+  /* The new thread inherits our standard input and output. */
+  fd_table = fd_table_create (thread_current ()->fd_table);
+  if (fd_table == NULL)
+    return TID_ERROR;
+#endif
+
   /* Allocate thread. */
-  t = palloc_get_page (PAL_ZERO);
+  t = alloc_thread_page ();
   if (t == NULL)
-    return TID_ERROR;
+    {
+#ifdef FILESYS
+      fd_table_destroy (fd_table);
+#endif
+      return TID_ERROR;
+    }
 
   /* Initialize thread. */
   init_thread (t, name, priority);
@@ -231,8 +392,7 @@ thread_create (const char *name, int priority,
 #endif
 
 #ifdef FILESYS
-  t->fd_table = (struct file**)calloc (128, sizeof (struct file*));
-  t->open_cnt = 3;
+  t->fd_table = fd_table;
 #endif
 
   /* Stack frame for kernel_thread(). */
@@ -271,6 +431,11 @@ thread_block (void)
   struct thread *t = thread_current ();
   if (t != idle_thread)
     ready_threads -= 1;
+  if (thread_mlfqs) {
+    /* Until it is unblocked, T's recent_cpu decays lazily. */
+    list_push_back (&stale_list, &t->stale_elem);
+    t->mlfqs_stale = true;
+  }
   t->status = THREAD_BLOCKED;
   schedule ();
 }
@@ -294,14 +459,58 @@ thread_unblock (struct thread *t)
   ASSERT (t->status == THREAD_BLOCKED);
   if (strcmp (t->name, "idle"))
     ready_threads += 1;
-  if (!thread_mlfqs) {
-	list_push_back (&ready_list, &t->elem);
-  }
-  else {
-    list_push_back (&ready_lists[t->priority], &t->elem);	
-  }
+  if (t->mlfqs_stale)
+    mlfqs_catch_up (t);
+  ready_queue_push (t);
   t->status = THREAD_READY;
+  t->ready_since = rdtsc ();
+  t->woken = true;
+  intr_set_level (old_level);
+}
+
+/* Returns a page to hold a new thread's struct thread and
+   kernel stack, or a null pointer if memory is exhausted.
+   Unlike a fresh page from palloc_get_page (PAL_ZERO), a page
+   from the cache is not cleared: init_thread() clears the struct
+   thread, and the stack does not need it. */
+static struct thread *
+alloc_thread_page (void)
+{
+  struct thread *t = NULL;
+  enum intr_level old_level;
+
+  old_level = intr_disable ();
+  if (page_cache_cnt > 0)
+    t = page_cache[--page_cache_cnt];
+  intr_set_level (old_level);
+
+  if (t == NULL)
+    t = palloc_get_page (0);
+  return t;
+}
+
+/* Frees the page of T, a thread that has exited, keeping it for
+   a future thread if there is room. */
+void
+thread_free_page (struct thread *t)
+{
+  enum intr_level old_level;
+
+  ASSERT (t != initial_thread);
+
+  /* Make stale pointers to T fail is_thread(). */
+  t->magic = 0;
+
+  old_level = intr_disable ();
+  if (thread_cache_pages && page_cache_cnt < THREAD_PAGE_CACHE_SIZE)
+    {
+      page_cache[page_cache_cnt++] = t;
+      t = NULL;
+    }
   intr_set_level (old_level);
+
+  if (t != NULL)
+    palloc_free_page (t);
 }
 
 /* Returns the name of the running thread. */
@@ -363,14 +572,8 @@ thread_exit (void)
     file_close (t->executable);
   }
 
-  struct file **fd_table = t->fd_table; 
-  int i;
-  for (i = 3; i < OPEN_CNT_MAX; i++) {
-    struct file *f = fd_table[i];
-    if (f)
-      file_close (f);
-  }
-  free (fd_table);
+  if (t->fd_table != NULL)
+    fd_table_destroy (t->fd_table);
 #endif
 
   /* Remove thread from all threads list, set our status to dying,
@@ -379,6 +582,8 @@ thread_exit (void)
   intr_disable ();
   struct thread *cur = thread_current ();
   list_remove (&cur->allelem);
+  if (cur->mlfqs_dirty)
+    list_remove (&cur->dirty_elem);
 #ifdef USERPROG
   if (cur->p_ptr) {
     cur->status = THREAD_ZOMBIE;
@@ -411,14 +616,8 @@ thread_yield (void)
   ASSERT (!intr_context ());
 
   old_level = intr_disable ();
-  if (cur != idle_thread) {
-    if (!thread_mlfqs) {
-	  list_push_back (&ready_list, &cur->elem);
-	}
-    else {	
-   	  list_push_back (&ready_lists[cur->priority], &cur->elem);
-	}
-  }
+  if (cur != idle_thread)
+    ready_queue_push (cur);
   cur->status = THREAD_READY;
   schedule ();
   intr_set_level (old_level);
@@ -442,12 +641,43 @@ thread_foreach (thread_action_func *func, void *aux)
 }
 
 void thread_set_priority_tail (int new_priority) {
-  if (list_empty (&ready_list)) return;
-  if (new_priority < thread_with_highest_priority_in_list (&ready_list)->priority) {  
+  if (new_priority < highest_priority_in_ready_lists ()) {  
     thread_yield ();
   }
 }
 
+/* Changes T's priority to PRIORITY.  If T is in the run queue it
+   is moved to the list for its new priority, and if it is in a
+   wait queue its place there is updated, so callers that change
+   the priority of a thread other than the running one must use
+   this instead of writing T->priority directly. */
+void
+thread_update_priority (struct thread *t, int priority)
+{
+  enum intr_level old_level;
+
+  ASSERT (is_thread (t));
+  ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+
+  old_level = intr_disable ();
+  if (t->status == THREAD_READY && t != idle_thread
+      && t->priority != priority)
+    {
+      ready_queue_remove (t);
+      t->priority = priority;
+      ready_queue_push (t);
+    }
+  else if (t->status == THREAD_BLOCKED && t->wait_queue != NULL
+           && t->priority != priority)
+    {
+      t->priority = priority;
+      heap_update (t->wait_queue, &t->wait_elem);
+    }
+  else
+    t->priority = priority;
+  intr_set_level (old_level);
+}
+
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void
 thread_set_priority (int new_priority)
@@ -455,29 +685,17 @@ thread_set_priority (int new_priority)
   if (thread_mlfqs) return;
 
   struct thread *t = thread_current ();
-  if (new_priority == t->priority) return;
+  enum intr_level old_level = intr_disable ();
   /* 为什么是new_priority而不是priority。因为original_priority是
    * 用来记录priority donation之前的原始优先级。这里set_priority
    * 的作用是重置线程优先级，所以original_priority=new_priority
    * 就像thread_create时，original_priority = priority,因为要实现优先级调度
    * 所以未必会将new_priority赋给t->priority */
   t->original_priority = new_priority;
-  int should_set_priority = 1;
-  struct list_elem *e;
-  for (e = list_begin (&t->locks); e != list_end (&t->locks); e = list_next (e)) {
-	struct lock *lock = list_entry (e, struct lock, elem);
-	struct list waiters = lock->semaphore.waiters;
-    if (!list_empty (&waiters)) {
-	  if (list_entry (list_begin (&waiters), struct thread, elem)->priority >= new_priority) {
-		should_set_priority = 0;
-		break;
-	  }
-	}
-  }
-  if (should_set_priority) {
-    t->priority = new_priority;
-    thread_set_priority_tail (new_priority);
-  }
+  int donated = donated_priority (t);
+  t->priority = new_priority > donated ? new_priority : donated;
+  intr_set_level (old_level);
+  thread_set_priority_tail (t->priority);
 }
 
 /* Returns the current thread's priority. */
@@ -542,6 +760,18 @@ idle (void *idle_started_ UNUSED)
       intr_disable ();
       thread_block ();
 
+      /* Nothing else wants to run, so zero a free page ahead of
+         time if any need it, then look again.  Interrupts stay on
+         meanwhile, so anything that wakes up can preempt us. */
+      intr_enable ();
+      if (palloc_zero_page ())
+        continue;
+      intr_disable ();
+
+      /* In tickless mode, stop the periodic timer interrupt
+         until there is something for it to do. */
+      timer_idle ();
+
       /* Re-enable interrupts and wait for the next one.
 
          The `sti' instruction disables interrupts until the
@@ -606,8 +836,8 @@ init_thread (struct thread *t, const char *name, int priority)
   strlcpy (t->name, name, sizeof t->name);
   t->stack = (uint8_t *) t + PGSIZE;
   t->magic = THREAD_MAGIC;
-  t->remaining_ticks = -1;
-  list_init (&t->locks);
+  t->run_since = rdtsc ();
+  held_locks_init (&t->locks);
   if (!thread_mlfqs) {
     t->priority = priority;
     t->original_priority = priority;
@@ -623,6 +853,7 @@ init_thread (struct thread *t, const char *name, int priority)
 	  t->recent_cpu = parent->recent_cpu;
 	}
 	t->priority = compute_priority (t->nice, t->recent_cpu);
+	t->decay_epoch = decay_epoch;
   }
   old_level = intr_disable ();
   list_push_back (&all_list, &t->allelem);
@@ -650,16 +881,18 @@ alloc_frame (struct thread *t, size_t size)
 static struct thread *
 next_thread_to_run (void)
 {
-  if (!thread_mlfqs) {
-    if (list_empty (&ready_list)) return idle_thread;
-    struct thread *t = thread_with_highest_priority_in_list (&ready_list);
-    list_remove (&t->elem);
-    return t;
-  }
   int priority = highest_priority_in_ready_lists ();
-  if (priority != -1)
-    return list_entry (list_pop_front (&ready_lists[priority]), struct thread, elem);
-  return idle_thread;
+  if (priority == -1) {
+    /* The idle thread runs without being unblocked. */
+    if (idle_thread->mlfqs_stale)
+      mlfqs_catch_up (idle_thread);
+    return idle_thread;
+  }
+
+  struct thread *t = list_entry (list_front (&ready_lists[priority]),
+                                 struct thread, elem);
+  ready_queue_remove (t);
+  return t;
 }
 
 /* Completes a thread switch by activating the new thread's page
@@ -704,7 +937,7 @@ thread_schedule_tail (struct thread *prev)
   if (prev != NULL && prev->status == THREAD_DYING && prev != initial_thread)
     {
       ASSERT (prev != cur);
-      palloc_free_page (prev);
+      thread_free_page (prev);
     }
 }
 
@@ -727,56 +960,238 @@ schedule (void)
   ASSERT (is_thread (next));
 
   if (cur != next)
-    prev = switch_threads (cur, next);
+    {
+      sched_account (cur, next);
+      prev = switch_threads (cur, next);
+    }
   thread_schedule_tail (prev);
 }
 
+/* Updates the scheduler statistics for a switch from CUR to
+   NEXT. */
+static void
+sched_account (struct thread *cur, struct thread *next)
+{
+  uint64_t now = rdtsc ();
+
+  if (cur != idle_thread)
+    {
+      sched_hist_add (&sched_totals.slice, now - cur->run_since);
+      if (cur->status == THREAD_READY)
+        {
+          cur->involuntary_switches++;
+          sched_totals.involuntary++;
+        }
+      else
+        {
+          cur->voluntary_switches++;
+          sched_totals.voluntary++;
+        }
+    }
+
+  if (next != idle_thread)
+    {
+      next->run_since = now;
+      if (next->woken)
+        {
+          uint64_t latency = now - next->ready_since;
+          sched_hist_add (&next->wake_latency, latency);
+          sched_hist_add (&sched_totals.wake_latency, latency);
+        }
+    }
+  next->woken = false;
+}
+
+/* Adds an interval of CYCLES to histogram H. */
+static void
+sched_hist_add (struct sched_hist *h, uint64_t cycles)
+{
+  int bucket = cycles != 0 ? 63 - __builtin_clzll (cycles) : 0;
+  if (bucket >= SCHED_HIST_BUCKETS)
+    bucket = SCHED_HIST_BUCKETS - 1;
+
+  h->count[bucket]++;
+  h->samples++;
+  h->total += cycles;
+  if (cycles > h->max)
+    h->max = cycles;
+}
+
 /* Returns a tid to use for a new thread. */
 static tid_t
 allocate_tid (void)
 {
   static tid_t next_tid = 1;
-  tid_t tid;
-
-  lock_acquire (&tid_lock);
-  tid = next_tid++;
-  lock_release (&tid_lock);
+  tid_t tid = 1;
 
+  /* Atomically fetch and increment next_tid.  See [IA32-v2b]
+     "XADD". */
+  asm volatile ("lock xaddl %0, %1" : "+r" (tid), "+m" (next_tid)
+                : : "memory");
   return tid;
+}
+
+/* Starts a new second for the MLFQS: records this second's
+   recent_cpu decay coefficient and applies it to the running
+   thread.  Blocked threads pick it up in mlfqs_catch_up(); ready
+   threads in mlfqs_update_priorities(). */
+static void
+mlfqs_start_decay (void)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  /* Catch up the threads that still need the coefficient we are
+     about to overwrite. */
+  while (!list_empty (&stale_list)) {
+    struct thread *t = list_entry (list_front (&stale_list),
+                                   struct thread, stale_elem);
+    if (decay_epoch - t->decay_epoch < DECAY_HISTORY)
+      break;
+    mlfqs_catch_up (t);
+    list_push_back (&stale_list, &t->stale_elem);
+    t->mlfqs_stale = true;
+  }
+
+  fixed_point_t twice_load = fix_scale (load_avg, 2);
+  decay_coeff[decay_epoch % DECAY_HISTORY] =
+    fix_div (twice_load, fix_add (twice_load, fix_int (1)));
+  decay_epoch++;
 
+  mlfqs_decay (running_thread ());
 }
 
-static void 
-recompute_all_threads_priority () 
+/* Recomputes the priority of every thread whose recent_cpu has
+   changed since the last call.  If DECAYED, recent_cpu has just
+   decayed, so that includes every ready thread.
+
+   Ready threads whose priority changes move to the back of their
+   new run queue list, in order of creation. */
+static void
+mlfqs_update_priorities (bool decayed)
 {
-  struct list_elem *e;
-  for (e = list_begin (&all_list); e != list_end (&all_list); e = list_next (e)) {
-	struct thread *t = list_entry (e, struct thread, allelem);
-	int original_priority = t->priority;
-	t->priority = compute_priority (t->nice, t->recent_cpu);
-	if (t != idle_thread && t->status == THREAD_READY && t->priority != original_priority) {
-	  list_remove (&t->elem);
-	  list_push_back (&ready_lists[t->priority], &t->elem);
-	}
+  struct list movers;
+  list_init (&movers);
+
+  if (decayed) {
+    int i;
+    for (i = PRI_MIN; i <= PRI_MAX; i++) {
+      struct list_elem *e = list_begin (&ready_lists[i]);
+      while (e != list_end (&ready_lists[i])) {
+        struct thread *t = list_entry (e, struct thread, elem);
+        e = list_next (e);
+        mlfqs_update_thread (t, &movers);
+      }
+    }
+  }
+
+  while (!list_empty (&dirty_list)) {
+    struct thread *t = list_entry (list_pop_front (&dirty_list),
+                                   struct thread, dirty_elem);
+    t->mlfqs_dirty = false;
+    mlfqs_update_thread (t, &movers);
+  }
+
+  list_sort (&movers, tid_less, NULL);
+  while (!list_empty (&movers)) {
+    struct thread *t = list_entry (list_pop_front (&movers),
+                                   struct thread, elem);
+    ready_queue_push (t);
   }
 }
 
+/* Brings T's recent_cpu up to date and recomputes its priority.
+   If T is ready and its priority changes, takes it off the run
+   queue and appends it to MOVERS. */
 static void
-recompute_all_threads_recent_cpu ()
+mlfqs_update_thread (struct thread *t, struct list *movers)
 {
-  struct list_elem *e;
-  for (e = list_begin (&all_list); e != list_end (&all_list); e = list_next (e)) {
-	struct thread *t = list_entry (e, struct thread, allelem);
-	t->recent_cpu = recompute_recent_cpu (load_avg, t->recent_cpu, t->nice);
+  if (t->mlfqs_stale && t->decay_epoch != decay_epoch) {
+    /* Keep stale_list in decay_epoch order. */
+    list_remove (&t->stale_elem);
+    list_push_back (&stale_list, &t->stale_elem);
+  }
+  mlfqs_decay (t);
+
+  int priority = compute_priority (t->nice, t->recent_cpu);
+  if (priority == t->priority)
+    return;
+  if (t->status == THREAD_READY && t != idle_thread) {
+    ready_queue_remove (t);
+    t->priority = priority;
+    list_push_back (movers, &t->elem);
+  }
+  else
+    thread_update_priority (t, priority);
+}
+
+/* Takes blocked thread T off stale_list and, if it has missed
+   any recent_cpu decays, applies them and recomputes its
+   priority. */
+static void
+mlfqs_catch_up (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->mlfqs_stale);
+
+  list_remove (&t->stale_elem);
+  t->mlfqs_stale = false;
+  if (t->decay_epoch != decay_epoch) {
+    mlfqs_decay (t);
+    thread_update_priority (t, compute_priority (t->nice, t->recent_cpu));
+  }
+}
+
+/* Applies to blocked thread T the recent_cpu decays that it has
+   missed, if any, and recomputes its priority, so that a wait
+   queue can choose among its waiters as if every thread's
+   priority were always recomputed.  T stays on stale_list.
+
+   Unlike thread_update_priority(), this does not restore the
+   order of T's wait queue.  It is meant to be called for every
+   thread in the queue through heap_update_all(), which does. */
+void
+thread_mlfqs_refresh (struct thread *t)
+{
+  ASSERT (intr_get_level () == INTR_OFF);
+  ASSERT (t->status == THREAD_BLOCKED);
+
+  if (t->mlfqs_stale && t->decay_epoch != decay_epoch) {
+    /* Keep stale_list in decay_epoch order. */
+    list_remove (&t->stale_elem);
+    list_push_back (&stale_list, &t->stale_elem);
+    mlfqs_decay (t);
+    t->priority = compute_priority (t->nice, t->recent_cpu);
+  }
+}
+
+/* Applies every recent_cpu decay that T has missed. */
+static void
+mlfqs_decay (struct thread *t)
+{
+  while (t->decay_epoch != decay_epoch) {
+    fixed_point_t coeff = decay_coeff[t->decay_epoch % DECAY_HISTORY];
+    t->recent_cpu = fix_add (fix_mul (coeff, t->recent_cpu),
+                             fix_int (t->nice));
+    t->decay_epoch++;
   }
 }
 
+/* Orders threads by thread identifier, which is the order in
+   which they were created. */
+static bool
+tid_less (const struct list_elem *a, const struct list_elem *b,
+          void *aux UNUSED)
+{
+  return (list_entry (a, struct thread, elem)->tid
+          < list_entry (b, struct thread, elem)->tid);
+}
+
 static int
 compute_priority (int nice, fixed_point_t recent_cpu)
 {
   fixed_point_t P = fix_int (PRI_MAX);
-  fixed_point_t r = fix_div (recent_cpu, fix_int (4));
-  fixed_point_t n = fix_mul (fix_int (2), fix_int (nice));
+  fixed_point_t r = fix_unscale (recent_cpu, 4);
+  fixed_point_t n = fix_int (2 * nice);
   int priority = fix_trunc (fix_sub (fix_sub (P, r), n));
   if (priority < PRI_MIN) return PRI_MIN;
   if (priority > PRI_MAX) return PRI_MAX;
@@ -787,42 +1202,43 @@ static fixed_point_t
 recompute_load_avg (fixed_point_t load_avg) 
 {
 //  printf ("c l_a=%d ready_threads=%d\n", load_avg.f, ready_threads);
-  fixed_point_t a = fix_mul (fix_div (fix_int (59), fix_int (60)), load_avg);
-  fixed_point_t b = fix_mul (fix_inv (fix_int (60)), fix_int (ready_threads));
+  fixed_point_t a = fix_mul (load_avg_coeff, load_avg);
+  fixed_point_t b = fix_scale (ready_coeff, ready_threads);
   return fix_add (a, b);
 }
 
-static fixed_point_t
-recompute_recent_cpu (fixed_point_t load_avg, fixed_point_t recent_cpu, int nice)
+/* Appends T to the run queue list for its priority. */
+static void
+ready_queue_push (struct thread *t)
 {
-  fixed_point_t a = fix_mul (fix_int (2), load_avg);
-  fixed_point_t b = fix_add (a, fix_int (1));
-  fixed_point_t c = fix_div (a, b);
-  return fix_add (fix_mul (c, recent_cpu), fix_int (nice));
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  list_push_back (&ready_lists[t->priority], &t->elem);
+  ready_mask |= (uint64_t) 1 << t->priority;
+  nr_ready++;
 }
 
-struct thread *
-thread_with_highest_priority_in_list (struct list *list)
+/* Removes T from the run queue list for its priority. */
+static void
+ready_queue_remove (struct thread *t)
 {
-  struct list_elem *e;
-  struct thread *rval = NULL;
-  for (e = list_begin (list); e != list_end(list); e = list_next (e)) {
-	struct thread *t = list_entry (e, struct thread, elem);
-	if (!rval || (rval && t->priority > rval->priority))
-	  rval = t;
-  }
-  return rval;
+  ASSERT (intr_get_level () == INTR_OFF);
+
+  list_remove (&t->elem);
+  if (list_empty (&ready_lists[t->priority]))
+    ready_mask &= ~((uint64_t) 1 << t->priority);
+  nr_ready--;
 }
 
+/* Returns the highest priority with a ready thread, or -1 if the
+   run queue is empty. */
 static int
 highest_priority_in_ready_lists ()
 {
-  int i;
-  for (i = PRI_MAX; i > PRI_MIN-1; i--) {
-	if (!list_empty (&ready_lists[i]))
-	  return i;
-  }
-  return -1;
+  uint64_t mask = ready_mask;
+  if (mask == 0)
+    return -1;
+  return 63 - __builtin_clzll (mask);
 }
 
 /* Offset of `stack' member within `struct thread'.
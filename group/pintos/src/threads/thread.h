@@ -2,6 +2,8 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <hash.h>
+#include <heap.h>
 #include <list.h>
 #include <stdint.h>
 #include "threads/synch.h"
@@ -27,8 +29,37 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Histogram of intervals measured in CPU cycles by the time
+   stamp counter.  Bucket I counts the intervals of at least 2**I
+   cycles but less than 2**(I+1), except that bucket 0 also counts
+   empty intervals and the last bucket everything longer. */
+#define SCHED_HIST_BUCKETS 32
+struct sched_hist
+  {
+    unsigned count[SCHED_HIST_BUCKETS]; /* Buckets. */
+    unsigned samples;                   /* Sum of count[]. */
+    uint64_t total;                     /* Sum of all intervals. */
+    uint64_t max;                       /* Longest interval. */
+  };
+
+/* Run queue lengths up to this are counted separately; longer
+   ones share the last bucket. */
+#define SCHED_RQ_BUCKETS 16
+
+/* System-wide scheduler statistics, as returned by
+   thread_get_sched_stats().  The idle thread is left out. */
+struct sched_stats
+  {
+    struct sched_hist wake_latency;     /* thread_unblock() to running. */
+    struct sched_hist slice;            /* Running to switched out. */
+    unsigned long long voluntary;       /* Switches on block or exit. */
+    unsigned long long involuntary;     /* Switches on yield or preemption. */
+    unsigned rq_count[SCHED_RQ_BUCKETS]; /* Run queue lengths seen. */
+    unsigned long long rq_samples;      /* # of samples, one per tick. */
+    unsigned long long rq_total;        /* Sum of sampled lengths. */
+    int rq_max;                         /* Longest run queue seen. */
+  };
 
-#define OPEN_CNT_MAX 128
 
 /* A kernel thread or user process.
 
@@ -80,12 +111,13 @@ typedef int tid_t;
    the `magic' member of the running thread's `struct thread' is
    set to THREAD_MAGIC.  Stack overflow will normally change this
    value, triggering the assertion. */
-/* The `elem' member has a dual purpose.  It can be an element in
-   the run queue (thread.c), or it can be an element in a
-   semaphore wait list (synch.c).  It can be used these two ways
-   only because they are mutually exclusive: only a thread in the
+/* The `elem' member is an element in the run queue (thread.c),
+   and the `wait_elem' member is an element in a semaphore or
+   condition variable wait queue (synch.c).  Only a thread in the
    ready state is on the run queue, whereas only a thread in the
-   blocked state is on a semaphore wait list. */
+   blocked state is in a wait queue.  Wait queues are ordered by
+   priority, so whoever changes the priority of a thread in one
+   must go through thread_update_priority(). */
 struct thread
   {
     /* Owned by thread.c. */
@@ -98,6 +130,8 @@ struct thread
 
     /* Shared between thread.c and synch.c. */
     struct list_elem elem;              /* List element. */
+    struct heap_elem wait_elem;         /* Wait queue element. */
+    struct heap *wait_queue;            /* Wait queue we are in, or null. */
 
 #ifdef USERPROG
     /* Owned by userprog/process.c. */
@@ -107,14 +141,30 @@ struct thread
     /* Owned by thread.c. */
     unsigned magic;                     /* Detects stack overflow. */
 
-	int remaining_ticks;
+	int64_t wakeup_tick;             /* Tick to wake up at, in timer_sleep(). */
+	struct heap_elem sleep_elem;     /* Element in timer.c's sleepers heap. */
 	
 	int original_priority;
-	struct list locks;              /* 线程持有的锁     */
+	struct heap locks;              /* 线程持有的锁     */
 	struct lock *lock_wanted;       /* 导致线程阻塞的锁 */
+	struct rwlock *rwlock_wanted;   /* Write lock whose readers we wait for. */
+	struct rwlock_hold read_holds[RWLOCK_READ_MAX]; /* Read locks held. */
     
 	int nice;
 	fixed_point_t recent_cpu;
+	unsigned decay_epoch;            /* recent_cpu decays applied so far. */
+	bool mlfqs_dirty;                /* Ran since priority was recomputed? */
+	bool mlfqs_stale;                /* Blocked, on thread.c's stale_list? */
+	struct list_elem dirty_elem;
+	struct list_elem stale_elem;
+
+	/* Scheduler statistics, see thread_get_sched_stats(). */
+	struct sched_hist wake_latency;  /* thread_unblock() to running. */
+	unsigned voluntary_switches;     /* Times we blocked. */
+	unsigned involuntary_switches;   /* Times we yielded or were preempted. */
+	uint64_t ready_since;            /* TSC when last unblocked. */
+	uint64_t run_since;              /* TSC when last switched in. */
+	bool woken;                      /* Unblocked but not yet run? */
         
 #ifdef USERPROG
 	int exit_status;                 /* 用于父进程wait */
@@ -125,11 +175,21 @@ struct thread
 	struct semaphore load_sema;      /* 用于装载用户程序时，父子进程的同步 */
 	struct semaphore wait_sema;       /* 父进程wait时sema_down子进程的sema。
 					    子进程thread_exit完成前，sema_up */
+	size_t resident_pages;           /* User pages in memory. */
+	size_t peak_resident_pages;      /* Most that ever were. */
+	struct sq_ring *sq_ring;         /* Registered system call rings, */
+	struct cq_ring *cq_ring;         /* ...or null (user addresses). */
+#endif
+
+#ifdef VM
+	struct hash pages;               /* Supplemental page table (vm/page.c). */
+	struct list mappings;            /* Memory mappings (vm/mmap.c). */
+	int next_mapid;                  /* Identifier for the next one. */
+	void *user_esp;                  /* User stack pointer in syscalls. */
 #endif
 
 #ifdef FILESYS
-       unsigned open_cnt;
-       struct file **fd_table;
+       struct fd_table *fd_table;        /* File descriptors (fdtable.c). */
        struct file *executable;          /* 此内核线程要执行的可执行用户程序 */
 #endif
   };
@@ -139,6 +199,12 @@ struct thread
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true (default), the pages of threads that exit are kept for
+   reuse by new threads instead of going back to the page
+   allocator.  Turned off by the spawn-rate test to measure the
+   difference. */
+extern bool thread_cache_pages;
+
 void thread_init (void);
 void thread_start (void);
 
@@ -157,6 +223,7 @@ tid_t thread_tid (void);
 const char *thread_name (void);
 
 void thread_exit (void) NO_RETURN;
+void thread_free_page (struct thread *);
 void thread_yield (void);
 
 /* Performs some operation on thread t, given auxiliary data AUX. */
@@ -171,7 +238,10 @@ void thread_set_nice (int);
 int thread_get_recent_cpu (void);
 int thread_get_load_avg (void);
 
-struct thread *thread_with_highest_priority_in_list (struct list *);
+void thread_get_sched_stats (struct sched_stats *);
+
 
 void thread_set_priority_tail (int);
+void thread_update_priority (struct thread *, int);
+void thread_mlfqs_refresh (struct thread *);
 #endif /* threads/thread.h */
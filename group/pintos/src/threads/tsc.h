@@ -0,0 +1,20 @@
+#ifndef THREADS_TSC_H
+#define THREADS_TSC_H
+
+#include <stdint.h>
+
+/* Reads and returns the time stamp counter, which counts CPU
+   cycles since reset.  Cheap enough to call on every lock
+   operation or context switch, and much finer grained than
+   timer ticks, but only meaningful for measuring intervals on a
+   single CPU. */
+static inline uint64_t
+rdtsc (void)
+{
+  /* See [IA32-v2b] "RDTSC". */
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+#endif /* threads/tsc.h */
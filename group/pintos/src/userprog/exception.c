@@ -4,7 +4,12 @@
 #include "userprog/gdt.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#include "threads/vaddr.h"
 #include "userprog/syscall.h"
+#include "userprog/uaccess.h"
+#ifdef VM
+#include "vm/page.h"
+#endif
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -149,6 +154,28 @@ page_fault (struct intr_frame *f)
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
+#ifdef VM
+  /* A page that is not present may just not have been brought in
+     yet.  The kernel touches user pages too, on behalf of system
+     calls. */
+  if (not_present && is_user_vaddr (fault_addr) && page_in (fault_addr))
+    return;
+
+  /* Or it may be on the stack, below what has been used so far.
+     In the kernel, the user stack pointer is the one saved on
+     entry to the system call. */
+  if (not_present
+      && page_grow_stack (fault_addr,
+                          user ? f->esp : thread_current ()->user_esp))
+    return;
+#endif
+
+  /* A fault in the kernel on a user address that the kernel was
+     copying to or from for a system call just makes the copy
+     fail. */
+  if (!user && is_user_vaddr (fault_addr) && uaccess_fixup (f))
+    return;
+
   if (user) {
   /* To implement virtual memory, delete the rest of the function
      body, and replace it with code that brings in the page to
@@ -0,0 +1,260 @@
+#include "userprog/fdtable.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "userprog/pipe.h"
+
+/* Slots in a new descriptor table.  Tables double in size as
+   they fill up, up to FD_TABLE_MAX. */
+#define FD_TABLE_INIT 32
+
+/* Descriptors that a child process inherits: standard input,
+   output and error. */
+#define FD_INHERIT_CNT 3
+
+/* A process's file descriptor table.  Only its owner uses it,
+   so it needs no lock.
+
+   The bitmap of descriptors in use keeps a summary of which of
+   its words are full, so finding the lowest free descriptor
+   takes a couple of word scans however many are open. */
+struct fd_table
+  {
+    struct open_file **files;   /* Indexed by descriptor, null if free. */
+    struct bitmap *used;        /* Descriptors in use. */
+    size_t size;                /* Number of slots. */
+  };
+
+/* The keyboard and the console.  Each holds a reference of its
+   own, so that they are never freed. */
+static struct open_file stdin_file = {OPEN_STDIN, 1, NULL, NULL};
+static struct open_file stdout_file = {OPEN_STDOUT, 1, NULL, NULL};
+
+static bool grow (struct fd_table *, size_t min_size);
+
+/* Creates and returns a new open file description of the given
+   KIND for FILE or PIPE, holding one reference, which the
+   caller owns.  Returns a null pointer if memory allocation
+   fails. */
+struct open_file *
+open_file_create (enum open_kind kind, struct file *file, struct pipe *pipe)
+{
+  struct open_file *of = malloc (sizeof *of);
+  if (of != NULL)
+    {
+      of->kind = kind;
+      of->ref_cnt = 1;
+      of->file = file;
+      of->pipe = pipe;
+    }
+  return of;
+}
+
+/* Adds a reference to OF and returns it.  Descriptions are
+   shared between processes, so the count is updated with
+   interrupts off. */
+struct open_file *
+open_file_dup (struct open_file *of)
+{
+  enum intr_level old_level = intr_disable ();
+  of->ref_cnt++;
+  intr_set_level (old_level);
+  return of;
+}
+
+/* Drops a reference to OF.  When the last one goes, closes the
+   file or pipe end that OF refers to and frees OF. */
+void
+open_file_close (struct open_file *of)
+{
+  enum intr_level old_level;
+  int ref_cnt;
+
+  old_level = intr_disable ();
+  ASSERT (of->ref_cnt > 0);
+  ref_cnt = --of->ref_cnt;
+  intr_set_level (old_level);
+  if (ref_cnt > 0)
+    return;
+
+  switch (of->kind)
+    {
+    case OPEN_FILE:
+      file_close (of->file);
+      break;
+    case OPEN_PIPE_READ:
+    case OPEN_PIPE_WRITE:
+      pipe_close (of->pipe, of->kind == OPEN_PIPE_WRITE);
+      break;
+    default:
+      NOT_REACHED ();
+    }
+  free (of);
+}
+
+/* Creates and returns a descriptor table for a child of the
+   process that owns PARENT.  Descriptors 0 through 2 share
+   PARENT's open file descriptions, so that the child reads and
+   writes wherever its parent redirected them; no others are
+   inherited, so a child never holds a pipe end that it does not
+   know about.  If PARENT is null, descriptor 0 refers to the
+   keyboard and descriptors 1 and 2 to the console instead.
+   Returns a null pointer if memory allocation fails. */
+struct fd_table *
+fd_table_create (const struct fd_table *parent)
+{
+  struct fd_table *t = malloc (sizeof *t);
+  size_t fd;
+
+  if (t == NULL)
+    return NULL;
+  t->size = FD_TABLE_INIT;
+  t->files = calloc (t->size, sizeof *t->files);
+  t->used = bitmap_create_with_summary (t->size);
+  if (t->files == NULL || t->used == NULL)
+    {
+      free (t->files);
+      if (t->used != NULL)
+        bitmap_destroy (t->used);
+      free (t);
+      return NULL;
+    }
+
+  if (parent != NULL)
+    {
+      for (fd = 0; fd < FD_INHERIT_CNT; fd++)
+        if (parent->files[fd] != NULL)
+          {
+            t->files[fd] = open_file_dup (parent->files[fd]);
+            bitmap_mark (t->used, fd);
+          }
+    }
+  else
+    {
+      fd_install (t, 0, open_file_dup (&stdin_file));
+      fd_install (t, 1, open_file_dup (&stdout_file));
+      fd_install (t, 2, open_file_dup (&stdout_file));
+    }
+  return t;
+}
+
+/* Closes every descriptor in T and frees T. */
+void
+fd_table_destroy (struct fd_table *t)
+{
+  size_t fd;
+
+  for (fd = 0; fd < t->size; fd++)
+    if (t->files[fd] != NULL)
+      open_file_close (t->files[fd]);
+  bitmap_destroy (t->used);
+  free (t->files);
+  free (t);
+}
+
+/* Makes the lowest free descriptor in T refer to OF, taking over
+   the caller's reference to OF, and returns the descriptor.
+   Returns -1, leaving the reference with the caller, if T is
+   full and cannot grow. */
+int
+fd_alloc (struct fd_table *t, struct open_file *of)
+{
+  size_t fd = bitmap_scan (t->used, 0, 1, false);
+
+  if (fd == BITMAP_ERROR)
+    {
+      fd = t->size;
+      if (!grow (t, fd + 1))
+        return -1;
+    }
+  bitmap_mark (t->used, fd);
+  t->files[fd] = of;
+  return fd;
+}
+
+/* Makes descriptor FD in T refer to OF, taking over the caller's
+   reference to OF, and closes what FD referred to before, if
+   anything.  Returns true if successful, or false, leaving the
+   reference with the caller, if FD is out of range or T cannot
+   grow to hold it. */
+bool
+fd_install (struct fd_table *t, int fd, struct open_file *of)
+{
+  struct open_file *old;
+
+  if (fd < 0 || fd >= FD_TABLE_MAX
+      || ((size_t) fd >= t->size && !grow (t, fd + 1)))
+    return false;
+
+  old = t->files[fd];
+  bitmap_mark (t->used, fd);
+  t->files[fd] = of;
+  if (old != NULL)
+    open_file_close (old);
+  return true;
+}
+
+/* Returns the open file description that descriptor FD in T
+   refers to, or a null pointer if FD is not open. */
+struct open_file *
+fd_lookup (const struct fd_table *t, int fd)
+{
+  return fd >= 0 && (size_t) fd < t->size ? t->files[fd] : NULL;
+}
+
+/* Frees descriptor FD in T and returns the open file description
+   it referred to, along with its reference, or a null pointer if
+   FD was not open. */
+struct open_file *
+fd_remove (struct fd_table *t, int fd)
+{
+  struct open_file *of = fd_lookup (t, fd);
+
+  if (of != NULL)
+    {
+      t->files[fd] = NULL;
+      bitmap_reset (t->used, fd);
+    }
+  return of;
+}
+
+/* Grows T to at least MIN_SIZE slots, at most FD_TABLE_MAX.
+   Returns true if successful, false if MIN_SIZE is too big or
+   memory allocation fails. */
+static bool
+grow (struct fd_table *t, size_t min_size)
+{
+  struct open_file **files;
+  struct bitmap *used;
+  size_t size, fd;
+
+  if (min_size > FD_TABLE_MAX)
+    return false;
+  for (size = t->size; size < min_size; size *= 2)
+    continue;
+  if (size > FD_TABLE_MAX)
+    size = FD_TABLE_MAX;
+
+  used = bitmap_create_with_summary (size);
+  if (used == NULL)
+    return false;
+  files = realloc (t->files, size * sizeof *files);
+  if (files == NULL)
+    {
+      bitmap_destroy (used);
+      return false;
+    }
+  memset (files + t->size, 0, (size - t->size) * sizeof *files);
+  for (fd = 0; fd < t->size; fd++)
+    if (files[fd] != NULL)
+      bitmap_mark (used, fd);
+
+  bitmap_destroy (t->used);
+  t->files = files;
+  t->used = used;
+  t->size = size;
+  return true;
+}
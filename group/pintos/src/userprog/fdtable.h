@@ -0,0 +1,44 @@
+#ifndef USERPROG_FDTABLE_H
+#define USERPROG_FDTABLE_H
+
+#include <stdbool.h>
+
+/* Most file descriptors a process can have, which bounds how
+   far its descriptor table grows. */
+#define FD_TABLE_MAX 1024
+
+/* What an open file description refers to. */
+enum open_kind
+  {
+    OPEN_STDIN,                 /* Keyboard. */
+    OPEN_STDOUT,                /* Console. */
+    OPEN_FILE,                  /* File in the file system. */
+    OPEN_PIPE_READ,             /* Read end of a pipe. */
+    OPEN_PIPE_WRITE             /* Write end of a pipe. */
+  };
+
+/* An open file description, which file descriptors refer to.
+   Descriptors that dup2() copies, and the standard descriptors
+   that a child process inherits from its parent, share one, and
+   so share its file position. */
+struct open_file
+  {
+    enum open_kind kind;        /* What it is. */
+    int ref_cnt;                /* Number of descriptors for it. */
+    struct file *file;          /* File, for OPEN_FILE. */
+    struct pipe *pipe;          /* Pipe, for OPEN_PIPE_*. */
+  };
+
+struct open_file *open_file_create (enum open_kind, struct file *,
+                                    struct pipe *);
+struct open_file *open_file_dup (struct open_file *);
+void open_file_close (struct open_file *);
+
+struct fd_table *fd_table_create (const struct fd_table *parent);
+void fd_table_destroy (struct fd_table *);
+int fd_alloc (struct fd_table *, struct open_file *);
+bool fd_install (struct fd_table *, int fd, struct open_file *);
+struct open_file *fd_lookup (const struct fd_table *, int fd);
+struct open_file *fd_remove (struct fd_table *, int fd);
+
+#endif /* userprog/fdtable.h */
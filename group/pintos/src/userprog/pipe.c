@@ -0,0 +1,153 @@
+#include "userprog/pipe.h"
+#include <debug.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Bytes a pipe can hold. */
+#define PIPE_SIZE PGSIZE
+
+/* A pipe: a ring buffer with a read end and a write end.
+   Readers block while it is empty and writers while it is full,
+   until the other side catches up or goes away. */
+struct pipe
+  {
+    struct lock lock;           /* Protects all the members below. */
+    struct condition readable;  /* Signaled when data or EOF arrives. */
+    struct condition writable;  /* Signaled when room is made. */
+    uint8_t *buf;               /* PIPE_SIZE bytes of data. */
+    size_t head;                /* Offset of next byte to read. */
+    size_t tail;                /* Offset of next byte to write. */
+    int readers;                /* Open read ends. */
+    int writers;                /* Open write ends. */
+  };
+
+/* Creates a pipe with one open read end and one open write end.
+   Returns the new pipe, or a null pointer if memory allocation
+   fails. */
+struct pipe *
+pipe_create (void)
+{
+  struct pipe *p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+
+  p->buf = palloc_get_page (0);
+  if (p->buf == NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  lock_init (&p->lock);
+  cond_init (&p->readable);
+  cond_init (&p->writable);
+  p->head = p->tail = 0;
+  p->readers = p->writers = 1;
+  return p;
+}
+
+/* Reads up to SIZE bytes from pipe P into BUFFER.  Waits until
+   the pipe is not empty, then reads whatever is there.  Returns
+   the number of bytes read, which is 0 only at end of file, that
+   is, once the pipe is empty and has no open write ends. */
+int
+pipe_read (struct pipe *p, void *buffer_, size_t size)
+{
+  uint8_t *buffer = buffer_;
+  size_t cnt = 0;
+
+  lock_acquire (&p->lock);
+  while (p->head == p->tail && p->writers > 0 && size > 0)
+    cond_wait (&p->readable, &p->lock);
+  while (cnt < size && p->head != p->tail)
+    {
+      size_t ofs = p->head % PIPE_SIZE;
+      size_t chunk = p->tail - p->head;
+
+      if (chunk > PIPE_SIZE - ofs)
+        chunk = PIPE_SIZE - ofs;
+      if (chunk > size - cnt)
+        chunk = size - cnt;
+      memcpy (buffer + cnt, p->buf + ofs, chunk);
+      p->head += chunk;
+      cnt += chunk;
+    }
+  if (cnt > 0)
+    cond_broadcast (&p->writable, &p->lock);
+  lock_release (&p->lock);
+
+  return cnt;
+}
+
+/* Writes SIZE bytes from BUFFER into pipe P, waiting for room as
+   necessary.  Returns the number of bytes written, which falls
+   short of SIZE only if the pipe's last read end is closed
+   meanwhile, or -1 if there was no read end to begin with. */
+int
+pipe_write (struct pipe *p, const void *buffer_, size_t size)
+{
+  const uint8_t *buffer = buffer_;
+  size_t cnt = 0;
+
+  lock_acquire (&p->lock);
+  if (p->readers == 0)
+    {
+      lock_release (&p->lock);
+      return -1;
+    }
+  while (cnt < size && p->readers > 0)
+    {
+      size_t ofs = p->tail % PIPE_SIZE;
+      size_t chunk = PIPE_SIZE - (p->tail - p->head);
+
+      if (chunk == 0)
+        {
+          cond_wait (&p->writable, &p->lock);
+          continue;
+        }
+      if (chunk > PIPE_SIZE - ofs)
+        chunk = PIPE_SIZE - ofs;
+      if (chunk > size - cnt)
+        chunk = size - cnt;
+      memcpy (p->buf + ofs, buffer + cnt, chunk);
+      p->tail += chunk;
+      cnt += chunk;
+      cond_broadcast (&p->readable, &p->lock);
+    }
+  lock_release (&p->lock);
+
+  return cnt;
+}
+
+/* Closes one of pipe P's write ends, if WRITER is true, or one of
+   its read ends, otherwise, waking up anyone waiting on the other
+   side.  Frees P when its last end is closed. */
+void
+pipe_close (struct pipe *p, bool writer)
+{
+  bool destroy;
+
+  lock_acquire (&p->lock);
+  if (writer)
+    {
+      ASSERT (p->writers > 0);
+      p->writers--;
+      cond_broadcast (&p->readable, &p->lock);
+    }
+  else
+    {
+      ASSERT (p->readers > 0);
+      p->readers--;
+      cond_broadcast (&p->writable, &p->lock);
+    }
+  destroy = p->readers == 0 && p->writers == 0;
+  lock_release (&p->lock);
+
+  if (destroy)
+    {
+      palloc_free_page (p->buf);
+      free (p);
+    }
+}
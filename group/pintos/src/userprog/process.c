@@ -19,10 +19,22 @@
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "threads/malloc.h"
+#include "threads/tsc.h"
+#ifdef VM
+#include "vm/mmap.h"
+#include "vm/page.h"
+#endif
 
 static thread_func start_process NO_RETURN;
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
 
+/* Statistics for process_print_stats().  Updated with interrupts
+   off. */
+static unsigned long long load_cnt;     /* Successful loads. */
+static unsigned long long load_cycles;  /* Time spent in them. */
+static unsigned long long exit_cnt;     /* Processes that exited. */
+static unsigned long long peak_resident_total; /* Sum of their peaks. */
+
 /* Starts a new thread running a user program loaded from
    FILENAME.  The new thread may be scheduled (and may even exit)
    before process_execute() returns.  Returns the new process's
@@ -63,7 +75,7 @@ process_execute (const char *file_name)
   if (t->load_success)
     return tid;
   list_remove (&(t->child_elem));
-  palloc_free_page (t);
+  thread_free_page (t);
   return TID_ERROR;
 }
 
@@ -74,6 +86,7 @@ start_process (void *file_name_)
 {
   char *file_name = file_name_;
   struct intr_frame if_;
+  uint64_t start;
   bool success;
 
   /* Initialize interrupt frame and load executable. */
@@ -81,7 +94,15 @@ start_process (void *file_name_)
   if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
   if_.cs = SEL_UCSEG;
   if_.eflags = FLAG_IF | FLAG_MBS;
+  start = rdtsc ();
   success = load (file_name, &if_.eip, &if_.esp);
+  if (success)
+    {
+      enum intr_level old_level = intr_disable ();
+      load_cnt++;
+      load_cycles += rdtsc () - start;
+      intr_set_level (old_level);
+    }
   thread_current ()->load_success = success;
   /* If load failed, quit. */
   palloc_free_page (file_name);
@@ -123,7 +144,7 @@ process_wait (tid_t child_tid UNUSED)
   ASSERT (t->status == THREAD_ZOMBIE);
   int exit_status = t->exit_status;
   list_remove (&(t->child_elem));
-  palloc_free_page (t);
+  thread_free_page (t);
   return exit_status;
 }
 
@@ -139,6 +160,16 @@ process_exit (void)
   pd = cur->pagedir;
   if (pd != NULL)
     {
+      enum intr_level old_level = intr_disable ();
+      exit_cnt++;
+      peak_resident_total += cur->peak_resident_pages;
+      intr_set_level (old_level);
+
+#ifdef VM
+      mmap_unmap_all ();
+      page_table_destroy ();
+#endif
+
       /* Correct ordering here is crucial.  We must set
          cur->pagedir to NULL before switching page directories,
          so that a timer interrupt can't switch back to the
@@ -168,7 +199,7 @@ process_exit (void)
     struct thread *t = list_entry (e, struct thread, child_elem);
     if (t->status == THREAD_ZOMBIE || t->status == THREAD_DYING) {
       list_pop_front (c_list);
-      palloc_free_page (t);
+      thread_free_page (t);
     }
     else {
       t->p_ptr = NULL;
@@ -178,6 +209,28 @@ process_exit (void)
   intr_set_level (old_level);
 }
 
+/* Adds DELTA to the number of pages that T has resident. */
+void
+process_count_resident (struct thread *t, int delta)
+{
+  enum intr_level old_level = intr_disable ();
+  t->resident_pages += delta;
+  if (t->resident_pages > t->peak_resident_pages)
+    t->peak_resident_pages = t->resident_pages;
+  intr_set_level (old_level);
+}
+
+/* Prints process statistics: how long loading an executable
+   took, and how many pages processes had resident at most. */
+void
+process_print_stats (void)
+{
+  printf ("Process: %llu loads, %llu cycles each on average\n",
+          load_cnt, load_cnt > 0 ? load_cycles / load_cnt : 0);
+  printf ("Process: %llu exits, %llu resident pages at peak on average\n",
+          exit_cnt, exit_cnt > 0 ? peak_resident_total / exit_cnt : 0);
+}
+
 /* Sets up the CPU for running user code in the current
    thread.
    This function is called on every context switch. */
@@ -199,6 +252,9 @@ process_init(struct thread *t)
 {
   t->exit_status = -1;
   t->load_success = false;
+  t->resident_pages = t->peak_resident_pages = 0;
+  t->sq_ring = NULL;
+  t->cq_ring = NULL;
   list_init (&(t->child_list));
   sema_init(&(t->load_sema), 0); 
   sema_init(&(t->wait_sema), 0);
@@ -308,6 +364,15 @@ load (const char *file_name, void (**eip) (void), void **esp)
   t->pagedir = pagedir_create ();
   if (t->pagedir == NULL)
     goto done;
+#ifdef VM
+  if (!page_table_init ())
+    {
+      pagedir_destroy (t->pagedir);
+      t->pagedir = NULL;
+      goto done;
+    }
+  mmap_init ();
+#endif
   process_activate ();
 
   int argc = 0;
@@ -426,7 +491,9 @@ load (const char *file_name, void (**eip) (void), void **esp)
 
 /* load() helpers. */
 
+#ifndef VM
 static bool install_page (void *upage, void *kpage, bool writable);
+#endif
 
 /* Checks whether PHDR describes a valid, loadable segment in
    FILE and returns true if so, false otherwise. */
@@ -486,7 +553,39 @@ validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
    user process if WRITABLE is true, read-only otherwise.
 
    Return true if successful, false if a memory allocation error
-   or disk read error occurs. */
+   or disk read error occurs.
+
+   With virtual memory, the pages are only recorded in the
+   supplemental page table here, to be read in from the
+   executable or zeroed when they are first touched. */
+#ifdef VM
+static bool
+load_segment (struct file *file UNUSED, off_t ofs, uint8_t *upage,
+              uint32_t read_bytes, uint32_t zero_bytes, bool writable)
+{
+  struct file *executable = thread_current ()->executable;
+
+  ASSERT ((read_bytes + zero_bytes) % PGSIZE == 0);
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (ofs % PGSIZE == 0);
+
+  while (read_bytes > 0 || zero_bytes > 0)
+    {
+      size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
+      size_t page_zero_bytes = PGSIZE - page_read_bytes;
+
+      if (!page_add_file (upage, executable, ofs, page_read_bytes, writable))
+        return false;
+
+      /* Advance. */
+      read_bytes -= page_read_bytes;
+      zero_bytes -= page_zero_bytes;
+      ofs += page_read_bytes;
+      upage += PGSIZE;
+    }
+  return true;
+}
+#else
 static bool
 load_segment (struct file *file, off_t ofs, uint8_t *upage,
               uint32_t read_bytes, uint32_t zero_bytes, bool writable)
@@ -531,12 +630,20 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
     }
   return true;
 }
+#endif
 
 /* Create a minimal stack by mapping a zeroed page at the top of
    user virtual memory. */
 static bool
 setup_stack (void **esp)
 {
+#ifdef VM
+  void *upage = ((uint8_t *) PHYS_BASE) - PGSIZE;
+  if (!page_add_zero (upage, true) || !page_in (upage))
+    return false;
+  *esp = PHYS_BASE;
+  return true;
+#else
   uint8_t *kpage;
   bool success = false;
 
@@ -550,6 +657,7 @@ setup_stack (void **esp)
         palloc_free_page (kpage);
     }
   return success;
+#endif
 }
 
 /* push parameters for user main function onto user stack */
@@ -596,6 +704,7 @@ push_params(char **tokens, int argc, void **esp)
 }
 
 
+#ifndef VM
 /* Adds a mapping from user virtual address UPAGE to kernel
    virtual address KPAGE to the page table.
    If WRITABLE is true, the user process may modify the page;
@@ -612,6 +721,10 @@ install_page (void *upage, void *kpage, bool writable)
 
   /* Verify that there's not already a page at that virtual
      address, then map our page there. */
-  return (pagedir_get_page (t->pagedir, upage) == NULL
-          && pagedir_set_page (t->pagedir, upage, kpage, writable));
+  if (pagedir_get_page (t->pagedir, upage) != NULL
+      || !pagedir_set_page (t->pagedir, upage, kpage, writable))
+    return false;
+  process_count_resident (t, 1);
+  return true;
 }
+#endif
@@ -7,6 +7,8 @@ tid_t process_execute (const char *file_name);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
+void process_count_resident (struct thread *, int delta);
+void process_print_stats (void);
 
 void process_init(struct thread *t);
 
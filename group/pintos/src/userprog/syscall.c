@@ -1,9 +1,14 @@
 #include "userprog/syscall.h"
 #include "userprog/process.h"
-#include "userprog/pagedir.h"
+#include "userprog/fdtable.h"
+#include "userprog/pipe.h"
+#include "userprog/uaccess.h"
 #include <stdio.h>
 #include <syscall-nr.h>
+#include <syscall-ring.h>
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
 #include "threads/synch.h"
@@ -14,10 +19,18 @@
 #include "devices/shutdown.h"
 #include "devices/input.h"
 #include "lib/string.h"
-#include "threads/synch.h"
+#ifdef VM
+#include "vm/mmap.h"
+#endif
+
+/* A buffer for readv() and writev(), laid out as in
+   lib/user/syscall.h. */
+struct iovec
+  {
+    void *iov_base;             /* Start of buffer. */
+    size_t iov_len;             /* Size of buffer in bytes. */
+  };
 
-/* stupid global file lock 做p3时去掉它*/
-static struct lock file_lock;
 static void syscall_handler (struct intr_frame *);
 tid_t sys_exec (const char *file);
 int sys_wait (tid_t tid);
@@ -31,130 +44,298 @@ int sys_filesize (int fd);
 void sys_seek (int fd, unsigned position);
 unsigned sys_tell (int fd);
 void sys_close (int fd);
-int check_bytes (void *start_, size_t size);
-int check_args(uint32_t *args);
-int check_string(const char *s);
-
-static int argcs[16];
+int sys_pread (int fd, void *buffer, unsigned size, unsigned offset);
+int sys_pwrite (int fd, void *buffer, unsigned size, unsigned offset);
+int sys_readv (int fd, const struct iovec *iov, int iovcnt);
+int sys_writev (int fd, const struct iovec *iov, int iovcnt);
+bool sys_ring_setup (struct sq_ring *sq, struct cq_ring *cq);
+bool sys_pipe (int *fds);
+int sys_dup2 (int oldfd, int newfd);
+int sys_ring_enter (unsigned to_submit);
+#ifdef VM
+mapid_t sys_mmap (int fd, void *addr);
+void sys_munmap (mapid_t mapping);
+#endif
+
+static bool copy_in_string (char *dst, const char *ustr, size_t size);
+static int positional_io (int fd, void *buffer, unsigned size,
+                          unsigned offset, bool write);
+static int vector_io (int fd, const struct iovec *iov, int iovcnt,
+                      bool write);
+static struct open_file *lookup_fd (int fd);
+static struct file *lookup_file (int fd);
+static int file_io (struct open_file *, void *buffer, unsigned size,
+                    off_t *pos, bool write);
+static off_t transfer (struct open_file *, uint8_t *kbuf, unsigned size,
+                       off_t *pos, bool write);
+static int ring_execute (const struct ring_sqe *);
+
+/* Size of the buffers that file names are copied into.  Longer
+   names are rejected as if the file system did not like them. */
+#define NAME_BUF_SIZE 128
+
+/* Most arguments a system call takes. */
+#define SYSCALL_ARGS_MAX 4
+
+/* Handler for a system call.  ARGS holds the call's arguments,
+   as many as its syscall_table entry says it takes.  The return
+   value goes into the user's eax. */
+typedef uint32_t syscall_func (const uint32_t args[]);
+
+/* A system call. */
+struct syscall
+  {
+    int argc;                   /* Number of arguments. */
+    syscall_func *func;         /* Handler, or null if none. */
+  };
+
+static syscall_func call_halt, call_exit, call_exec, call_wait;
+static syscall_func call_create, call_remove, call_open, call_filesize;
+static syscall_func call_read, call_write, call_seek, call_tell;
+static syscall_func call_close, call_practice;
+static syscall_func call_pread, call_pwrite, call_readv, call_writev;
+static syscall_func call_ring_setup, call_ring_enter, call_pipe, call_dup2;
+#ifdef VM
+static syscall_func call_mmap, call_munmap;
+#endif
+
+/* System calls, indexed by number. */
+static const struct syscall syscall_table[] =
+  {
+    [SYS_HALT] = {0, call_halt},
+    [SYS_EXIT] = {1, call_exit},
+    [SYS_EXEC] = {1, call_exec},
+    [SYS_WAIT] = {1, call_wait},
+    [SYS_CREATE] = {2, call_create},
+    [SYS_REMOVE] = {1, call_remove},
+    [SYS_OPEN] = {1, call_open},
+    [SYS_FILESIZE] = {1, call_filesize},
+    [SYS_READ] = {3, call_read},
+    [SYS_WRITE] = {3, call_write},
+    [SYS_SEEK] = {2, call_seek},
+    [SYS_TELL] = {1, call_tell},
+    [SYS_CLOSE] = {1, call_close},
+    [SYS_PRACTICE] = {1, call_practice},
+    [SYS_PREAD] = {4, call_pread},
+    [SYS_PWRITE] = {4, call_pwrite},
+    [SYS_READV] = {3, call_readv},
+    [SYS_WRITEV] = {3, call_writev},
+    [SYS_RING_SETUP] = {2, call_ring_setup},
+    [SYS_RING_ENTER] = {1, call_ring_enter},
+    [SYS_PIPE] = {1, call_pipe},
+    [SYS_DUP2] = {2, call_dup2},
+#ifdef VM
+    [SYS_MMAP] = {2, call_mmap},
+    [SYS_MUNMAP] = {1, call_munmap},
+#endif
+  };
+
+#define SYSCALL_CNT (sizeof syscall_table / sizeof *syscall_table)
 
 void
 syscall_init (void)
 {
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
-  lock_init (&file_lock);
-  argcs[SYS_PRACTICE] = 1;
-  argcs[SYS_HALT] = 0;
-  argcs[SYS_EXIT] = 1;
-  argcs[SYS_EXEC] = 1;
-  argcs[SYS_WAIT] = 1;
-
-  argcs[SYS_CREATE] = 2;
-  argcs[SYS_REMOVE] = 1;
-  argcs[SYS_OPEN] = 1;
-  argcs[SYS_WRITE] = 3;
-  argcs[SYS_READ] = 3;
-  argcs[SYS_CLOSE] = 1;
-  argcs[SYS_FILESIZE] = 1;
-  argcs[SYS_SEEK] = 2;
-  argcs[SYS_TELL] = 1;
 }
 
+/* Copies the system call number and arguments from the user
+   stack and calls the handler from syscall_table.  User memory
+   is accessed with the functions in userprog/uaccess.c, which
+   fail instead of faulting, and any failure kills the process. */
 static void
-syscall_handler (struct intr_frame *f UNUSED)
-{
-  uint32_t* args = ((uint32_t*) f->esp);
-  if (!check_args(args)) {
-    sys_exit(-1);
-  }
-
-  if (args[0] == SYS_WRITE) {
-    int fd = args[1]; 
-    void *buffer = (void*)args[2];
-    unsigned size = args[3];
-    int result =  sys_write(fd, buffer, size);
-    f->eax = result;
-  }
-
-  if (args[0] == SYS_PRACTICE) {
-    f->eax = args[1] + 1;
-  }
-
-  if (args[0] == SYS_EXEC) {
-    char *file = (char*)args[1];
-    f->eax = sys_exec (file);
-  }
-
-  if (args[0] == SYS_WAIT) {
-    tid_t tid = args[1];
-    f->eax = sys_wait (tid); 
-  }
-
-  if (args[0] == SYS_HALT) {
-    sys_halt ();
-  }
-
-  if (args[0] == SYS_EXIT) {
-    f->eax = args[1];
-    sys_exit(args[1]);
-  }
-
-  if (args[0] == SYS_CREATE) {
-    f->eax = sys_create ((char*)args[1], (unsigned)args[2]);
-  }
-
-  if (args[0] == SYS_REMOVE) {
-    f->eax = sys_remove ((char*)args[1]);
-  }
-
-  if (args[0] == SYS_OPEN) {
-    f->eax = sys_open ((char*)args[1]);
-  }
-
-  if (args[0] == SYS_READ) {
-    int fd = args[1]; 
-    void *buffer = (void*)args[2];
-    unsigned size = args[3];
-    f->eax =  sys_read (fd, buffer, size);
-  }
-  
-  if (args[0] == SYS_FILESIZE) {
-    f->eax = sys_filesize ((int)args[1]);
-  }
-
-  if (args[0] == SYS_SEEK) {
-    sys_seek ((int)args[1], (unsigned)args[2]);
-  }
-
-  if (args[0] == SYS_TELL) {
-    f->eax = sys_tell ((int)args[1]);
-  }
-
-  if (args[0] == SYS_CLOSE) {
-    sys_close ((int)args[1]);
-  }
+syscall_handler (struct intr_frame *f)
+{
+  const uint32_t *usp = f->esp;
+  uint32_t args[SYSCALL_ARGS_MAX];
+  const struct syscall *sc;
+  uint32_t nr;
+
+#ifdef VM
+  /* The kernel may fault on the user stack on our behalf, and then
+     needs this to know whether to grow it. */
+  thread_current ()->user_esp = f->esp;
+#endif
+  if (!copy_from_user (&nr, usp, sizeof nr)
+      || nr >= SYSCALL_CNT
+      || syscall_table[nr].func == NULL)
+    sys_exit (-1);
+
+  sc = &syscall_table[nr];
+  if (!copy_from_user (args, usp + 1, sc->argc * sizeof *args))
+    sys_exit (-1);
+  f->eax = sc->func (args);
+}
+
+static uint32_t
+call_halt (const uint32_t args[] UNUSED)
+{
+  sys_halt ();
+  NOT_REACHED ();
+}
+
+static uint32_t
+call_exit (const uint32_t args[])
+{
+  sys_exit (args[0]);
+}
+
+static uint32_t
+call_exec (const uint32_t args[])
+{
+  return sys_exec ((const char *) args[0]);
+}
+
+static uint32_t
+call_wait (const uint32_t args[])
+{
+  return sys_wait (args[0]);
+}
+
+static uint32_t
+call_create (const uint32_t args[])
+{
+  return sys_create ((const char *) args[0], args[1]);
 }
 
+static uint32_t
+call_remove (const uint32_t args[])
+{
+  return sys_remove ((const char *) args[0]);
+}
+
+static uint32_t
+call_open (const uint32_t args[])
+{
+  return sys_open ((const char *) args[0]);
+}
+
+static uint32_t
+call_filesize (const uint32_t args[])
+{
+  return sys_filesize (args[0]);
+}
+
+static uint32_t
+call_read (const uint32_t args[])
+{
+  return sys_read (args[0], (void *) args[1], args[2]);
+}
+
+static uint32_t
+call_write (const uint32_t args[])
+{
+  return sys_write (args[0], (void *) args[1], args[2]);
+}
+
+static uint32_t
+call_seek (const uint32_t args[])
+{
+  sys_seek (args[0], args[1]);
+  return 0;
+}
+
+static uint32_t
+call_tell (const uint32_t args[])
+{
+  return sys_tell (args[0]);
+}
+
+static uint32_t
+call_close (const uint32_t args[])
+{
+  sys_close (args[0]);
+  return 0;
+}
+
+static uint32_t
+call_practice (const uint32_t args[])
+{
+  return args[0] + 1;
+}
+
+static uint32_t
+call_pread (const uint32_t args[])
+{
+  return sys_pread (args[0], (void *) args[1], args[2], args[3]);
+}
+
+static uint32_t
+call_pwrite (const uint32_t args[])
+{
+  return sys_pwrite (args[0], (void *) args[1], args[2], args[3]);
+}
+
+static uint32_t
+call_readv (const uint32_t args[])
+{
+  return sys_readv (args[0], (const struct iovec *) args[1], args[2]);
+}
+
+static uint32_t
+call_writev (const uint32_t args[])
+{
+  return sys_writev (args[0], (const struct iovec *) args[1], args[2]);
+}
+
+static uint32_t
+call_ring_setup (const uint32_t args[])
+{
+  return sys_ring_setup ((struct sq_ring *) args[0],
+                         (struct cq_ring *) args[1]);
+}
+
+static uint32_t
+call_ring_enter (const uint32_t args[])
+{
+  return sys_ring_enter (args[0]);
+}
+
+static uint32_t
+call_pipe (const uint32_t args[])
+{
+  return sys_pipe ((int *) args[0]);
+}
+
+static uint32_t
+call_dup2 (const uint32_t args[])
+{
+  return sys_dup2 (args[0], args[1]);
+}
+
+#ifdef VM
+static uint32_t
+call_mmap (const uint32_t args[])
+{
+  return sys_mmap (args[0], (void *) args[1]);
+}
+
+static uint32_t
+call_munmap (const uint32_t args[])
+{
+  sys_munmap (args[0]);
+  return 0;
+}
+#endif
+
 bool
 sys_create (const char *file, unsigned initial_size)
 {
-  if (!check_string (file))
-    sys_exit (-1);
-  
-  lock_acquire (&file_lock);
-  bool result = filesys_create (file, initial_size);
-  lock_release (&file_lock);
+  char name[NAME_BUF_SIZE];
+  if (!copy_in_string (name, file, sizeof name))
+    return false;
+
+  bool result = filesys_create (name, initial_size);
   return result;
 }
 
 bool 
 sys_remove (const char *file)
 {
-  if (!check_string (file))
-    sys_exit (-1);
+  char name[NAME_BUF_SIZE];
+  if (!copy_in_string (name, file, sizeof name))
+    return false;
 
-  lock_acquire (&file_lock);
-  bool result = filesys_remove (file);
-  lock_release (&file_lock);
+  bool result = filesys_remove (name);
   return result;
 }
 
@@ -162,147 +343,476 @@ sys_remove (const char *file)
 int
 sys_open (const char *file)
 {
-  if (!check_string (file))
-    sys_exit (-1);
-
-  struct thread *t = thread_current ();
-  if (t->open_cnt >= OPEN_CNT_MAX)
+  char name[NAME_BUF_SIZE];
+  if (!copy_in_string (name, file, sizeof name))
     return -1;
-  if (!check_string (file))
-    sys_exit (-1);
 
-  lock_acquire (&file_lock);
-  struct file *f = filesys_open (file);
-  lock_release (&file_lock);
+  struct file *f = filesys_open (name);
   if (!f)
     return -1;
 
-  int i = 3;
-  struct file **fd_table = t->fd_table;
-  while (fd_table[i])
-    i++;
-  fd_table[i] = f;
-  t->open_cnt += 1;
-  return i; 
+  struct open_file *of = open_file_create (OPEN_FILE, f, NULL);
+  if (!of)
+    {
+      file_close (f);
+      return -1;
+    }
+
+  int fd = fd_alloc (thread_current ()->fd_table, of);
+  if (fd < 0)
+    open_file_close (of);
+  return fd;
 }
 
 int
 sys_write(int fd, void *buffer, unsigned size)
 {
-  if (fd <= 0 || fd == 2 || fd >= OPEN_CNT_MAX)
+  struct open_file *of = lookup_fd (fd);
+  if (!of)
     return -1;
 
-  if (!check_bytes (buffer, size))
-    sys_exit(-1);
+  return file_io (of, buffer, size, NULL, true);
+}
 
-  if (fd == 1) {
-    putbuf ((char*)buffer, size);
-    return size;
-  }
+int
+sys_read(int fd, void *buffer,  unsigned size)
+{
+  struct open_file *of = lookup_fd (fd);
+  if (!of)
+    return -1;
+  return file_io (of, buffer, size, NULL, false);
+}
 
-  struct file *f = thread_current ()->fd_table[fd];
-  if (!f)
+int
+sys_pread (int fd, void *buffer, unsigned size, unsigned offset)
+{
+  return positional_io (fd, buffer, size, offset, false);
+}
+
+int
+sys_pwrite (int fd, void *buffer, unsigned size, unsigned offset)
+{
+  return positional_io (fd, buffer, size, offset, true);
+}
+
+int
+sys_readv (int fd, const struct iovec *iov, int iovcnt)
+{
+  return vector_io (fd, iov, iovcnt, false);
+}
+
+int
+sys_writev (int fd, const struct iovec *iov, int iovcnt)
+{
+  return vector_io (fd, iov, iovcnt, true);
+}
+
+/* Creates a pipe and stores descriptors for its read and write
+   ends in user array FDS, in that order.  Returns true if
+   successful, false if memory or descriptors run out. */
+bool
+sys_pipe (int *fds)
+{
+  struct fd_table *table = thread_current ()->fd_table;
+  struct open_file *ends[2];
+  int kfds[2];
+  struct pipe *p;
+
+  if (!is_user_range (fds, sizeof kfds))
+    sys_exit (-1);
+
+  p = pipe_create ();
+  if (p == NULL)
+    return false;
+  ends[0] = open_file_create (OPEN_PIPE_READ, NULL, p);
+  ends[1] = open_file_create (OPEN_PIPE_WRITE, NULL, p);
+  if (ends[0] == NULL || ends[1] == NULL)
+    {
+      free (ends[0]);
+      free (ends[1]);
+      pipe_close (p, false);
+      pipe_close (p, true);
+      return false;
+    }
+
+  kfds[0] = fd_alloc (table, ends[0]);
+  kfds[1] = kfds[0] >= 0 ? fd_alloc (table, ends[1]) : -1;
+  if (kfds[1] < 0)
+    {
+      if (kfds[0] >= 0)
+        fd_remove (table, kfds[0]);
+      open_file_close (ends[0]);
+      open_file_close (ends[1]);
+      return false;
+    }
+
+  if (!copy_to_user (fds, kfds, sizeof kfds))
+    sys_exit (-1);
+  return true;
+}
+
+/* Makes descriptor NEWFD refer to what OLDFD does, closing
+   NEWFD first if it is open.  Returns NEWFD if successful, -1
+   if OLDFD is not open or NEWFD is out of range. */
+int
+sys_dup2 (int oldfd, int newfd)
+{
+  struct fd_table *table = thread_current ()->fd_table;
+  struct open_file *of = fd_lookup (table, oldfd);
+
+  if (of == NULL)
     return -1;
+  if (oldfd == newfd)
+    return newfd;
+
+  open_file_dup (of);
+  if (!fd_install (table, newfd, of))
+    {
+      open_file_close (of);
+      return -1;
+    }
+  return newfd;
+}
 
-  lock_acquire (&file_lock);
-  int result = file_write (f, buffer, size);
-  lock_release (&file_lock);
-  return result;
+/* Registers the user rings SQ and CQ, described in
+   lib/syscall-ring.h, as the running process's system call
+   rings, replacing any registered before.  Returns true if
+   successful, false if they are not in user memory. */
+bool
+sys_ring_setup (struct sq_ring *sq, struct cq_ring *cq)
+{
+  struct thread *t = thread_current ();
+
+  if (!is_user_range (sq, sizeof *sq) || !is_user_range (cq, sizeof *cq))
+    return false;
+  t->sq_ring = sq;
+  t->cq_ring = cq;
+  return true;
 }
 
+/* Carries out up to TO_SUBMIT of the calls queued in the running
+   process's submission ring, in order, posting each result in
+   its completion ring.  Stops early when the submission ring
+   runs dry or the completion ring fills up.  Returns the number
+   of calls carried out, or -1 if no rings are registered.
+
+   The rings are read and updated in place in user memory, so a
+   process that scribbles on them only hurts itself. */
 int
-sys_read(int fd, void *buffer,  unsigned size)
+sys_ring_enter (unsigned to_submit)
 {
-  if (fd < 0 || fd == 1 || fd == 2 || fd >= OPEN_CNT_MAX)
+  struct thread *t = thread_current ();
+  struct sq_ring *sq = t->sq_ring;
+  struct cq_ring *cq = t->cq_ring;
+  uint32_t sq_idx[2], cq_idx[2];        /* Head and tail. */
+  unsigned done;
+
+  if (sq == NULL)
     return -1;
+  if (!copy_from_user (sq_idx, &sq->head, sizeof sq_idx)
+      || !copy_from_user (cq_idx, &cq->head, sizeof cq_idx))
+    sys_exit (-1);
 
-  if (!check_bytes (buffer, size))
-    sys_exit(-1);
-  
-  unsigned cnt = 0;
-  char *buf = (char*)buffer;
-  if (fd == 0) {
-    while (cnt < size) {
-      uint8_t c = input_getc ();
-      buf[cnt] = c;
-      cnt++;
+  for (done = 0; done < to_submit; done++)
+    {
+      struct ring_sqe sqe;
+      struct ring_cqe cqe;
+
+      if (sq_idx[0] == sq_idx[1] || cq_idx[1] - cq_idx[0] >= RING_SIZE)
+        break;
+      if (!copy_from_user (&sqe, &sq->sqes[sq_idx[0] % RING_SIZE],
+                           sizeof sqe))
+        sys_exit (-1);
+      cqe.user_data = sqe.user_data;
+      cqe.result = ring_execute (&sqe);
+      if (!copy_to_user (&cq->cqes[cq_idx[1] % RING_SIZE], &cqe, sizeof cqe))
+        sys_exit (-1);
+      sq_idx[0]++;
+      cq_idx[1]++;
     }
-    return (int)cnt;
-  }
 
-  struct file *f = thread_current ()->fd_table[fd];
-  if (!f)
+  if (done > 0
+      && (!copy_to_user (&sq->head, &sq_idx[0], sizeof sq_idx[0])
+          || !copy_to_user (&cq->tail, &cq_idx[1], sizeof cq_idx[1])))
+    sys_exit (-1);
+  return done;
+}
+
+/* Carries out the system call described by submission ring
+   entry SQE and returns its result. */
+static int
+ring_execute (const struct ring_sqe *sqe)
+{
+  switch (sqe->op)
+    {
+    case RING_READ:
+      return sys_read (sqe->fd, sqe->buffer, sqe->size);
+    case RING_WRITE:
+      return sys_write (sqe->fd, sqe->buffer, sqe->size);
+    case RING_OPEN:
+      return sys_open (sqe->buffer);
+    case RING_CLOSE:
+      sys_close (sqe->fd);
+      return 0;
+    case RING_SEEK:
+      sys_seek (sqe->fd, sqe->size);
+      return 0;
+    default:
+      return -1;
+    }
+}
+
+/* Reads SIZE bytes from FD, starting at byte OFFSET, into user
+   BUFFER, or writes them from BUFFER to FD if WRITE is true.
+   Returns the number of bytes transferred, or -1 if FD is not
+   an open file.  The file position is left alone. */
+static int
+positional_io (int fd, void *buffer, unsigned size, unsigned offset,
+               bool write)
+{
+  struct open_file *of = lookup_fd (fd);
+  off_t pos = offset;
+
+  if (!of || of->kind != OPEN_FILE || pos < 0)
     return -1;
-  lock_acquire (&file_lock);
-  int result = file_read (f, buffer, size);
-  lock_release (&file_lock);
-  return result;
+  return file_io (of, buffer, size, &pos, write);
+}
+
+/* Reads from FD into the IOVCNT buffers described by user array
+   IOV, filling each in turn, or writes their contents to FD if
+   WRITE is true.  Returns the number of bytes transferred, which
+   falls short of the total if the end of file is reached, or -1
+   if FD is bad. */
+static int
+vector_io (int fd, const struct iovec *iov, int iovcnt, bool write)
+{
+  struct open_file *of = lookup_fd (fd);
+  int total = 0;
+  int i;
+
+  if (!of || iovcnt < 0)
+    return -1;
+
+  for (i = 0; i < iovcnt; i++)
+    {
+      struct iovec v;
+      int n;
+
+      if (!copy_from_user (&v, iov + i, sizeof v))
+        sys_exit (-1);
+      n = file_io (of, v.iov_base, v.iov_len, NULL, write);
+      if (n < 0)
+        return total > 0 ? total : -1;
+      total += n;
+      if ((size_t) n < v.iov_len)
+        break;
+    }
+  return total;
+}
+
+/* Returns the open file description that descriptor FD of the
+   running process refers to, or a null pointer if FD is not
+   open. */
+static struct open_file *
+lookup_fd (int fd)
+{
+  return fd_lookup (thread_current ()->fd_table, fd);
+}
+
+/* Returns the file that descriptor FD of the running process
+   refers to, or a null pointer if FD is not open or does not
+   refer to a file. */
+static struct file *
+lookup_file (int fd)
+{
+  struct open_file *of = lookup_fd (fd);
+  return of != NULL && of->kind == OPEN_FILE ? of->file : NULL;
+}
+
+/* Reads SIZE bytes from OF into user BUFFER, or writes them from
+   BUFFER to OF if WRITE is true, and returns the number of bytes
+   transferred, or -1 if OF cannot be read or written that way.
+   If POS is non-null, OF must be a file, the transfer starts at
+   byte offset *POS in it, which is advanced past the bytes
+   transferred, and the file position is left alone; otherwise
+   the file position is used.
+
+   The data goes through a kernel page, a page at a time, so the
+   file system never touches user memory.  That way it never
+   faults, and so never waits on an eviction, while it holds its
+   locks.  Kills the process if BUFFER is bad. */
+static int
+file_io (struct open_file *of, void *buffer, unsigned size, off_t *pos,
+         bool write)
+{
+  uint8_t *ubuf = buffer;
+  uint8_t *kbuf;
+  bool bad = false;
+  int total = 0;
+
+  if (write
+      ? of->kind == OPEN_STDIN || of->kind == OPEN_PIPE_READ
+      : of->kind == OPEN_STDOUT || of->kind == OPEN_PIPE_WRITE)
+    return -1;
+  if (!is_user_range (buffer, size))
+    sys_exit (-1);
+  if (size == 0)
+    return 0;
+
+  kbuf = palloc_get_page (0);
+  if (kbuf == NULL)
+    return -1;
+  while (size > 0)
+    {
+      unsigned chunk = size < PGSIZE ? size : PGSIZE;
+      off_t n;
+
+      if (write && !copy_from_user (kbuf, ubuf, chunk))
+        {
+          bad = true;
+          break;
+        }
+      n = transfer (of, kbuf, chunk, pos, write);
+      if (n < 0)
+        {
+          if (total == 0)
+            total = -1;
+          break;
+        }
+      if (!write && !copy_to_user (ubuf, kbuf, n))
+        {
+          bad = true;
+          break;
+        }
+
+      if (pos != NULL)
+        *pos += n;
+      total += n;
+      ubuf += n;
+      size -= n;
+      if (n < (off_t) chunk)
+        break;
+    }
+  palloc_free_page (kbuf);
+
+  if (bad)
+    sys_exit (-1);
+  return total;
+}
+
+/* Reads SIZE bytes from OF into kernel buffer KBUF, or writes
+   them from KBUF to OF if WRITE is true, at *POS if POS is
+   non-null, for file_io().  Returns the number of bytes
+   transferred.  A read from a pipe returns what is there, once
+   something is; a write to a pipe with no readers returns -1. */
+static off_t
+transfer (struct open_file *of, uint8_t *kbuf, unsigned size, off_t *pos,
+          bool write)
+{
+  off_t n;
+
+  switch (of->kind)
+    {
+    case OPEN_STDIN:
+      for (n = 0; n < (off_t) size; n++)
+        kbuf[n] = input_getc ();
+      return n;
+
+    case OPEN_STDOUT:
+      putbuf ((char *) kbuf, size);
+      return size;
+
+    case OPEN_FILE:
+      if (pos != NULL)
+        return (write
+                ? file_write_at (of->file, kbuf, size, *pos)
+                : file_read_at (of->file, kbuf, size, *pos));
+      return (write
+              ? file_write (of->file, kbuf, size)
+              : file_read (of->file, kbuf, size));
+
+    case OPEN_PIPE_READ:
+      return pipe_read (of->pipe, kbuf, size);
+
+    case OPEN_PIPE_WRITE:
+      return pipe_write (of->pipe, kbuf, size);
+    }
+  NOT_REACHED ();
 }
 
 int
 sys_filesize (int fd) {
-  if (fd < 3 || fd >= OPEN_CNT_MAX)
-    return -1;
-  struct file *f = thread_current ()->fd_table[fd];
+  struct file *f = lookup_file (fd);
   if (!f)
     return -1;
-  lock_acquire (&file_lock);
   int result = file_length (f); 
-  lock_release (&file_lock);
   return result;
 }
 
 void 
 sys_seek (int fd, unsigned position)
 {
-  if (fd < 3 || fd >= OPEN_CNT_MAX)
-    return;
-  struct file *f = thread_current ()->fd_table[fd];
+  struct file *f = lookup_file (fd);
   if (!f)
     return;
-  lock_acquire (&file_lock);
   file_seek (f, position);
-  lock_release (&file_lock);
 }
 
 unsigned
 sys_tell (int fd)
 {
-  if (fd < 3 || fd >= OPEN_CNT_MAX)
-    return -1;
-  struct file *f = thread_current ()->fd_table[fd];
+  struct file *f = lookup_file (fd);
   if (!f)
     return -1;
-  lock_acquire (&file_lock);
   unsigned result = file_tell (f);
-  lock_release (&file_lock);
   return result;
 }
 
+/* Descriptors 0 through 2 cannot be closed, only redirected with
+   dup2(), so that a process never loses its console. */
 void
 sys_close (int fd)
 {
-  if (fd < 3 || fd >= OPEN_CNT_MAX)
+  if (fd < 3)
     return;
 
-  struct thread *t = thread_current ();
-  struct file **fd_table = t->fd_table;
-  struct file *f = fd_table[fd];
-  if (!f)
+  struct open_file *of = fd_remove (thread_current ()->fd_table, fd);
+  if (!of)
     return;
-  fd_table[fd] = NULL;
-  lock_acquire (&file_lock);
-  file_close (f);
-  lock_release (&file_lock);
-  t->open_cnt -= 1;
+  open_file_close (of);
+}
+
+#ifdef VM
+mapid_t
+sys_mmap (int fd, void *addr)
+{
+  struct file *f = lookup_file (fd);
+  if (!f)
+    return MAP_FAILED;
+  return mmap_map (f, addr);
+}
+
+void
+sys_munmap (mapid_t mapping)
+{
+  mmap_unmap (mapping);
 }
+#endif
 
 tid_t
 sys_exec(const char *file) {
-  if (!check_string (file)) {
+  char *cmd_line = palloc_get_page (0);
+  tid_t tid;
+  int len;
+
+  if (cmd_line == NULL)
+    return TID_ERROR;
+  len = strncpy_from_user (cmd_line, file, PGSIZE);
+  tid = len >= 0 && len < PGSIZE ? process_execute (cmd_line) : TID_ERROR;
+  palloc_free_page (cmd_line);
+  if (len < 0)
     sys_exit (-1);
-  }
-  return process_execute(file);
+  return tid;
 }
 
 int
@@ -323,54 +833,15 @@ sys_exit(int status) {
 }
 
 
-/* 检查系统调用参数数组是否全部位于用户地址空间
- * 并且在页表里有相应的映射 */
-int
-check_args(uint32_t *args) {
-  /* 先检查第一个指针指向的元素是否越界 */
-  if (!check_bytes((void*)args, 4))
-    return 0;
-
-  /* 第一个元素没有越界，解引用获取系统调用号 */
-  int argc = argcs[args[0]];
-
-  args += 1;
-  if (!check_bytes((void*)args, sizeof (uint32_t) * argc))
-    return 0;
-
-  return 1;
-}
-
-int
-check_string(const char *s) {
-  const char *cp = s;
-  void *p = NULL;
-  while (check_bytes ((void*)cp, 1)) {
-    p = next_page (cp);
-    while ((void*)cp < p) {
-      /* 找到终止符返回true */
-      if (!(*cp))
-	return true;
-      cp++;
-    }
-  }
-  return false;
-}
-
-/* 检查以start为起点，大小为size bytes的连续数据
- * 是否在用户地址空间，并且在页表有相应的映射 */
-int
-check_bytes (void *start, size_t size) {
-  void *end = (void*)((uintptr_t)start + size); 
-  if (end == NULL || end >= PHYS_BASE)
-    return false;
-
-  void *p = pg_round_down ((void*)start);
-  while (p <= end) {
-    if (!pagedir_get_page (thread_current ()->pagedir, p))
-      return false;
-    p = next_page (p);
-  }
-  return true;
+/* Copies the null-terminated user string USTR into DST, which
+   holds SIZE bytes.  Returns true if successful, false if the
+   string is too long to fit.  Kills the process if USTR is
+   bad. */
+static bool
+copy_in_string (char *dst, const char *ustr, size_t size)
+{
+  int len = strncpy_from_user (dst, ustr, size);
+  if (len < 0)
+    sys_exit (-1);
+  return (size_t) len < size;
 }
-
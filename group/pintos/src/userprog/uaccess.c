@@ -0,0 +1,126 @@
+#include "userprog/uaccess.h"
+#include <debug.h>
+#include "threads/interrupt.h"
+
+/* Access to user memory from the kernel.
+
+   The functions here do not check that user memory is mapped
+   before touching it.  They just touch it.  If that faults and
+   the page fault handler cannot bring the page in, it looks up
+   the faulting instruction in the exception table and, if it is
+   there, resumes execution at the matching fixup address instead
+   of giving up.  The fixup code then reports the failure to the
+   caller.  Valid accesses, the common case, cost nothing beyond
+   the access itself. */
+
+/* An exception table entry: if the instruction at INSN faults,
+   execution resumes at FIXUP. */
+struct exception_entry
+  {
+    uintptr_t insn;             /* Address of faulting instruction. */
+    uintptr_t fixup;            /* Where to resume. */
+  };
+
+/* The exception table, which the linker collects from the
+   __ex_table sections of the object files (see
+   threads/kernel.lds.S). */
+extern const struct exception_entry _start_ex_table[], _end_ex_table[];
+
+/* Assembly that adds an exception table entry for the
+   instruction at label INSN, resuming at label FIXUP. */
+#define EX_TABLE(INSN, FIXUP)                   \
+        ".pushsection __ex_table, \"a\"\n"      \
+        ".balign 4\n"                           \
+        ".long " INSN ", " FIXUP "\n"           \
+        ".popsection\n"
+
+/* Reads the byte at user address UADDR, which must be below
+   PHYS_BASE.  Returns the byte if successful, -1 if a fault
+   occurred. */
+static inline int
+get_user (const uint8_t *uaddr)
+{
+  int result = -1;
+  asm volatile ("1: movzbl %1, %0\n"
+                "2:\n"
+                EX_TABLE ("1b", "2b")
+                : "+r" (result) : "m" (*uaddr));
+  return result;
+}
+
+/* Copies SIZE bytes from SRC to DST, one of which is in user
+   memory, and returns the number of bytes left uncopied because
+   of a fault, 0 if the copy succeeded.  A faulting REP MOVSB
+   leaves its count register holding the bytes still to go. */
+static size_t
+copy_user (void *dst, const void *src, size_t size)
+{
+  asm volatile ("1: rep movsb\n"
+                "2:\n"
+                EX_TABLE ("1b", "2b")
+                : "+c" (size), "+S" (src), "+D" (dst) : : "memory");
+  return size;
+}
+
+/* Copies SIZE bytes from user address USRC to kernel address
+   DST.  Returns true if successful, false if some of the source
+   is not valid user memory, in which case DST may have been
+   partly written. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size)
+{
+  return is_user_range (usrc, size) && copy_user (dst, usrc, size) == 0;
+}
+
+/* Copies SIZE bytes from kernel address SRC to user address
+   UDST.  Returns true if successful, false if some of the
+   destination is not valid, writable user memory, in which case
+   it may have been partly written. */
+bool
+copy_to_user (void *udst, const void *src, size_t size)
+{
+  return is_user_range (udst, size) && copy_user (udst, src, size) == 0;
+}
+
+/* Copies the null-terminated string at user address USRC to
+   kernel buffer DST, which holds SIZE bytes.  Returns the length
+   of the string, not counting the null terminator, if it fits in
+   DST, or SIZE if it does not, in which case DST is not null
+   terminated.  Returns -1 if the string is not valid user
+   memory. */
+int
+strncpy_from_user (char *dst, const char *usrc, size_t size)
+{
+  const uint8_t *src = (const uint8_t *) usrc;
+  size_t i;
+
+  for (i = 0; i < size; i++)
+    {
+      int c;
+
+      if (!is_user_vaddr (src + i) || (c = get_user (src + i)) < 0)
+        return -1;
+      dst[i] = c;
+      if (c == '\0')
+        return i;
+    }
+  return size;
+}
+
+/* Called by the page fault handler for a fault in the kernel
+   that it could not resolve.  If the faulting instruction is in
+   the exception table, arranges for F to resume at its fixup
+   address and returns true.  Otherwise returns false. */
+bool
+uaccess_fixup (struct intr_frame *f)
+{
+  const struct exception_entry *e;
+
+  for (e = _start_ex_table; e < _end_ex_table; e++)
+    if (e->insn == (uintptr_t) f->eip)
+      {
+        f->eip = (void (*) (void)) e->fixup;
+        return true;
+      }
+  return false;
+}
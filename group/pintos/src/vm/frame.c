@@ -0,0 +1,360 @@
+#include "vm/frame.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "vm/page.h"
+#include "vm/swap.h"
+
+/* Most frames evicted at once.  Taking several victims per
+   shortage lets their pages go out to adjacent swap slots in a
+   single pass, and lets the next few faults find a free frame
+   without scanning the frame table again. */
+#define EVICT_BATCH 8
+
+/* Frame table.  Every frame that holds a user page is on
+   frame_list, which the clock hand sweeps to find frames to
+   evict.  New frames go in just behind the hand, so they are
+   the last to be looked at.
+
+   frame_lock protects the frame table, the PINNED member of
+   every frame, and the FRAME and EVICTING members of every
+   page. */
+static struct list frame_list;
+static size_t frame_cnt;                /* Number of frames on it. */
+static struct list_elem *clock_hand;    /* Next frame to examine. */
+static struct lock frame_lock;
+
+/* Signaled when the eviction of a batch of pages completes. */
+static struct condition evict_done;
+
+/* Statistics, updated under frame_lock. */
+static unsigned long long evict_cnt;    /* Pages evicted. */
+static unsigned long long clean_cnt;    /* ...that went without a write. */
+static unsigned long long write_back_cnt; /* ...that went to their file. */
+static unsigned long long batch_cnt;    /* Calls to evict() that did. */
+static unsigned long long second_chance_cnt; /* Accessed bits cleared. */
+
+static bool evict (void);
+static size_t pick_victims (struct frame *[]);
+static void remove_frame (struct frame *);
+
+/* Initializes the frame table. */
+void
+frame_init (void)
+{
+  list_init (&frame_list);
+  clock_hand = list_end (&frame_list);
+  lock_init (&frame_lock);
+  cond_init (&evict_done);
+}
+
+/* Allocates a frame from the user pool for PAGE and returns it,
+   pinned.  If ZERO is true, the frame is filled with zeros.  If
+   the user pool is exhausted, evicts other pages to make room.
+   Returns a null pointer if no frame is available even so.
+
+   Once the frame is filled in and mapped, the caller passes it
+   to frame_install(), or to frame_free() to give up.  PAGE may
+   instead be null, for a frame that vm/share.c shares between
+   processes, which stays pinned until it is freed. */
+struct frame *
+frame_alloc (struct page *page, bool zero)
+{
+  struct frame *f = malloc (sizeof *f);
+  if (f == NULL)
+    return NULL;
+
+  while ((f->kpage = palloc_get_page (PAL_USER | (zero ? PAL_ZERO : 0)))
+         == NULL)
+    if (!evict ())
+      {
+        free (f);
+        return NULL;
+      }
+  f->page = page;
+  f->pinned = true;
+
+  lock_acquire (&frame_lock);
+  list_insert (clock_hand, &f->elem);
+  frame_cnt++;
+  lock_release (&frame_lock);
+  return f;
+}
+
+/* Records that frame F, obtained from frame_alloc() and now
+   mapped in its page's page directory, holds its page, and makes
+   it a candidate for eviction. */
+void
+frame_install (struct frame *f)
+{
+  lock_acquire (&frame_lock);
+  ASSERT (f->pinned);
+  f->page->frame = f;
+  f->pinned = false;
+  process_count_resident (f->page->thread, 1);
+  lock_release (&frame_lock);
+}
+
+/* Returns frame F, obtained from frame_alloc() but never passed
+   to frame_install(), to the user pool.  F must no longer be
+   mapped in any page directory. */
+void
+frame_free (struct frame *f)
+{
+  lock_acquire (&frame_lock);
+  remove_frame (f);
+  lock_release (&frame_lock);
+
+  palloc_free_page (f->kpage);
+  free (f);
+}
+
+/* Waits until PAGE is not being evicted, then returns true if it
+   is resident, false if it is not.  Only PAGE's owner may call
+   this, and then PAGE stays as it is until the owner changes
+   it, except that a resident page may be evicted. */
+bool
+frame_wait (struct page *page)
+{
+  bool resident;
+
+  lock_acquire (&frame_lock);
+  while (page->evicting)
+    cond_wait (&evict_done, &frame_lock);
+  resident = page->frame != NULL;
+  lock_release (&frame_lock);
+
+  return resident;
+}
+
+/* Waits until PAGE is not being evicted, then, if it is
+   resident, pins its frame and returns it, so that it stays put
+   until passed to frame_unpin().  Returns a null pointer if PAGE
+   is not resident.  Only PAGE's owner may call this. */
+struct frame *
+frame_pin (struct page *page)
+{
+  struct frame *f;
+
+  lock_acquire (&frame_lock);
+  while (page->evicting)
+    cond_wait (&evict_done, &frame_lock);
+  f = page->frame;
+  if (f != NULL)
+    {
+      ASSERT (!f->pinned);
+      f->pinned = true;
+    }
+  lock_release (&frame_lock);
+
+  return f;
+}
+
+/* Unpins frame F, pinned by frame_pin(). */
+void
+frame_unpin (struct frame *f)
+{
+  lock_acquire (&frame_lock);
+  ASSERT (f->pinned);
+  f->pinned = false;
+  lock_release (&frame_lock);
+}
+
+/* Unmaps PAGE, if it is resident, and frees the frame holding
+   it, first waiting for any eviction of it to finish. */
+void
+frame_release_page (struct page *page)
+{
+  struct frame *f;
+
+  lock_acquire (&frame_lock);
+  while (page->evicting)
+    cond_wait (&evict_done, &frame_lock);
+  f = page->frame;
+  if (f != NULL)
+    {
+      remove_frame (f);
+      page->frame = NULL;
+    }
+  lock_release (&frame_lock);
+
+  if (f != NULL)
+    {
+      pagedir_clear_page (page->thread->pagedir, page->upage);
+      palloc_free_page (f->kpage);
+      free (f);
+    }
+}
+
+/* Prints frame table statistics. */
+void
+frame_print_stats (void)
+{
+  printf ("Frame: %llu pages evicted in %llu batches, %llu of them clean, "
+          "%llu written back to files\n",
+          evict_cnt, batch_cnt, clean_cnt, write_back_cnt);
+  printf ("Frame: %llu second chances\n", second_chance_cnt);
+}
+
+/* Evicts up to EVICT_BATCH pages from their frames and returns
+   the frames to the user pool.  Pages that were modified since
+   they were last read in go to swap first, or to their file if
+   they map one; the rest can be read in again from where they
+   came from.  Returns true if at least
+   one frame was freed, false if none could be. */
+static bool
+evict (void)
+{
+  struct frame *victims[EVICT_BATCH];
+  struct frame *dirty[EVICT_BATCH];
+  size_t victim_cnt, dirty_cnt, written_cnt, freed_cnt;
+  swap_slot_t slot;
+  size_t i;
+
+  lock_acquire (&frame_lock);
+  victim_cnt = pick_victims (victims);
+  lock_release (&frame_lock);
+  if (victim_cnt == 0)
+    return false;
+
+  /* Unmap the victims, so that their owners fault and wait in
+     frame_wait() if they touch them from now on.  Then the dirty
+     bits can no longer change. */
+  dirty_cnt = written_cnt = 0;
+  for (i = 0; i < victim_cnt; i++)
+    {
+      struct page *p = victims[i]->page;
+      uint32_t *pd = p->thread->pagedir;
+
+      pagedir_clear_page (pd, p->upage);
+      if (p->dirty || pagedir_is_dirty (pd, p->upage))
+        {
+          /* A mapped file page goes back to its file.  Nobody
+             holding the file's lock can be waiting for this
+             eviction, because system calls copy file data
+             through kernel buffers, never faulting on user
+             pages while the file system holds its locks. */
+          if (p->write_back)
+            {
+              page_write_back (p, victims[i]->kpage);
+              p->dirty = false;
+              written_cnt++;
+              continue;
+            }
+          p->dirty = true;
+          dirty[dirty_cnt++] = victims[i];
+        }
+    }
+
+  /* Write the dirty pages out, to consecutive slots if there is
+     room, so that the disk sees one sequential run. */
+  slot = dirty_cnt > 0 ? swap_alloc (dirty_cnt) : SWAP_ERROR;
+  for (i = 0; i < dirty_cnt; i++)
+    {
+      struct page *p = dirty[i]->page;
+
+      p->swap_slot = slot != SWAP_ERROR ? slot + i : swap_alloc (1);
+      if (p->swap_slot != SWAP_ERROR)
+        swap_write (p->swap_slot, dirty[i]->kpage);
+    }
+
+  /* Detach the frames from their pages.  A dirty page that did
+     not fit in swap stays where it is. */
+  freed_cnt = 0;
+  lock_acquire (&frame_lock);
+  for (i = 0; i < victim_cnt; i++)
+    {
+      struct frame *f = victims[i];
+      struct page *p = f->page;
+
+      if (p->dirty && p->swap_slot == SWAP_ERROR)
+        {
+          pagedir_set_page (p->thread->pagedir, p->upage, f->kpage,
+                            p->writable);
+          f->pinned = false;
+        }
+      else
+        {
+          remove_frame (f);
+          p->frame = NULL;
+          process_count_resident (p->thread, -1);
+          victims[freed_cnt++] = f;
+        }
+      p->evicting = false;
+    }
+  evict_cnt += freed_cnt;
+  clean_cnt += victim_cnt - dirty_cnt - written_cnt;
+  write_back_cnt += written_cnt;
+  if (freed_cnt > 0)
+    batch_cnt++;
+  cond_broadcast (&evict_done, &frame_lock);
+  lock_release (&frame_lock);
+
+  for (i = 0; i < freed_cnt; i++)
+    {
+      palloc_free_page (victims[i]->kpage);
+      free (victims[i]);
+    }
+  return freed_cnt > 0;
+}
+
+/* Advances the clock hand around the frame table until it has
+   chosen EVICT_BATCH frames to evict, or gone around twice,
+   giving each frame whose page was accessed since the hand last
+   passed a second chance.  Stores the frames chosen in VICTIMS,
+   pinned and with their pages marked as being evicted, and
+   returns how many there are.  frame_lock must be held. */
+static size_t
+pick_victims (struct frame *victims[])
+{
+  size_t cnt = 0;
+  size_t scanned;
+
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  for (scanned = 0; cnt < EVICT_BATCH && scanned < 2 * frame_cnt; scanned++)
+    {
+      struct frame *f;
+      struct page *p;
+      uint32_t *pd;
+
+      if (clock_hand == list_end (&frame_list))
+        clock_hand = list_begin (&frame_list);
+      f = list_entry (clock_hand, struct frame, elem);
+      clock_hand = list_next (clock_hand);
+      if (f->pinned)
+        continue;
+
+      p = f->page;
+      pd = p->thread->pagedir;
+      if (pagedir_is_accessed (pd, p->upage))
+        {
+          pagedir_set_accessed (pd, p->upage, false);
+          second_chance_cnt++;
+          continue;
+        }
+
+      f->pinned = true;
+      p->evicting = true;
+      victims[cnt++] = f;
+    }
+  return cnt;
+}
+
+/* Removes F from the frame table, moving the clock hand past it
+   if need be.  frame_lock must be held. */
+static void
+remove_frame (struct frame *f)
+{
+  ASSERT (lock_held_by_current_thread (&frame_lock));
+
+  if (clock_hand == &f->elem)
+    clock_hand = list_next (clock_hand);
+  list_remove (&f->elem);
+  frame_cnt--;
+}
@@ -0,0 +1,36 @@
+#ifndef VM_FRAME_H
+#define VM_FRAME_H
+
+#include <list.h>
+#include <stdbool.h>
+
+struct page;
+
+/* A frame of physical memory in the user pool that holds a user
+   page.
+
+   A pinned frame is never chosen for eviction.  Frames are
+   pinned from frame_alloc() until frame_install(), while their
+   contents are filled in, while they are being evicted, and
+   between frame_pin() and frame_unpin(). */
+struct frame
+  {
+    void *kpage;                /* Kernel virtual address. */
+    struct page *page;          /* Page it holds, null if shared. */
+    bool pinned;                /* Exempt from eviction? */
+    struct list_elem elem;      /* Element in frame table. */
+  };
+
+void frame_init (void);
+struct frame *frame_alloc (struct page *, bool zero);
+void frame_install (struct frame *);
+void frame_free (struct frame *);
+
+bool frame_wait (struct page *);
+struct frame *frame_pin (struct page *);
+void frame_unpin (struct frame *);
+void frame_release_page (struct page *);
+
+void frame_print_stats (void);
+
+#endif /* vm/frame.h */
@@ -0,0 +1,128 @@
+#include "vm/mmap.h"
+#include <debug.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/page.h"
+
+static struct mapping *lookup_mapping (mapid_t);
+static void unmap (struct mapping *);
+
+/* Initializes the running thread's list of mappings. */
+void
+mmap_init (void)
+{
+  struct thread *t = thread_current ();
+
+  list_init (&t->mappings);
+  t->next_mapid = 0;
+}
+
+/* Maps FILE into the running thread's address space starting at
+   ADDR, page by page.  Nothing is read until the pages are
+   touched, and then straight into the frames that hold them.
+   Returns the new mapping's identifier, or MAP_FAILED if FILE is
+   empty, ADDR is null or not page-aligned, any page in the range
+   is already in use or is not a user page, or memory allocation
+   failed. */
+mapid_t
+mmap_map (struct file *file, void *addr)
+{
+  struct thread *t = thread_current ();
+  struct mapping *m;
+  off_t length;
+  size_t i;
+
+  if (addr == NULL || pg_ofs (addr) != 0)
+    return MAP_FAILED;
+
+  m = malloc (sizeof *m);
+  if (m == NULL)
+    return MAP_FAILED;
+
+  m->file = file_reopen (file);
+  length = m->file != NULL ? file_length (m->file) : 0;
+  if (length == 0 || (uintptr_t) addr + length > (uintptr_t) PHYS_BASE
+      || (uintptr_t) addr + length < (uintptr_t) addr)
+    {
+      file_close (m->file);
+      free (m);
+      return MAP_FAILED;
+    }
+
+  m->id = t->next_mapid++;
+  m->base = addr;
+  m->page_cnt = 0;
+  list_push_back (&t->mappings, &m->elem);
+
+  for (i = 0; i < (size_t) length; i += PGSIZE)
+    {
+      size_t read_bytes = length - i < PGSIZE ? length - i : PGSIZE;
+
+      if (!page_add_mmap ((uint8_t *) addr + i, m->file, i, read_bytes))
+        {
+          unmap (m);
+          return MAP_FAILED;
+        }
+      m->page_cnt++;
+    }
+  return m->id;
+}
+
+/* Removes the running thread's mapping MAPPING, writing back any
+   pages that were changed.  Returns false if there is no such
+   mapping. */
+bool
+mmap_unmap (mapid_t mapping)
+{
+  struct mapping *m = lookup_mapping (mapping);
+
+  if (m == NULL)
+    return false;
+  unmap (m);
+  return true;
+}
+
+/* Removes all of the running thread's mappings, writing back any
+   pages that were changed. */
+void
+mmap_unmap_all (void)
+{
+  struct list *mappings = &thread_current ()->mappings;
+
+  while (!list_empty (mappings))
+    unmap (list_entry (list_front (mappings), struct mapping, elem));
+}
+
+/* Returns the running thread's mapping with identifier ID, or a
+   null pointer if there is none. */
+static struct mapping *
+lookup_mapping (mapid_t id)
+{
+  struct list *mappings = &thread_current ()->mappings;
+  struct list_elem *e;
+
+  for (e = list_begin (mappings); e != list_end (mappings);
+       e = list_next (e))
+    {
+      struct mapping *m = list_entry (e, struct mapping, elem);
+      if (m->id == id)
+        return m;
+    }
+  return NULL;
+}
+
+/* Unmaps the pages of M, closes its file, and frees it. */
+static void
+unmap (struct mapping *m)
+{
+  size_t i;
+
+  for (i = 0; i < m->page_cnt; i++)
+    page_unmap (page_lookup ((uint8_t *) m->base + i * PGSIZE));
+
+  file_close (m->file);
+  list_remove (&m->elem);
+  free (m);
+}
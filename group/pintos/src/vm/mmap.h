@@ -0,0 +1,29 @@
+#ifndef VM_MMAP_H
+#define VM_MMAP_H
+
+#include <list.h>
+#include <stddef.h>
+
+struct file;
+
+/* Memory mapping identifier. */
+typedef int mapid_t;
+#define MAP_FAILED ((mapid_t) -1)
+
+/* A file mapped into a process's address space by mmap_map().
+   Each of its pages is a page_add_mmap() page. */
+struct mapping
+  {
+    mapid_t id;                 /* Identifier returned to the user. */
+    struct file *file;          /* Mapped file, reopened. */
+    void *base;                 /* First mapped page. */
+    size_t page_cnt;            /* Number of mapped pages. */
+    struct list_elem elem;      /* Element in thread's mappings. */
+  };
+
+void mmap_init (void);
+mapid_t mmap_map (struct file *, void *addr);
+bool mmap_unmap (mapid_t);
+void mmap_unmap_all (void);
+
+#endif /* vm/mmap.h */
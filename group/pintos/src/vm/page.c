@@ -0,0 +1,322 @@
+#include "vm/page.h"
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/tsc.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "vm/frame.h"
+#include "vm/share.h"
+#include "vm/swap.h"
+
+/* Most bytes that a user stack may grow to.  Set with the
+   "-stack-max" kernel command-line option. */
+size_t page_stack_max = 8 * 1024 * 1024;
+
+static hash_hash_func page_hash;
+static hash_less_func page_less;
+static hash_action_func page_destroy;
+
+/* Page fault statistics for page_print_stats(), updated with
+   interrupts off: pages brought in, and the time that took. */
+static unsigned long long fault_cnt;
+static unsigned long long fault_cycles;
+static unsigned long long swap_in_cnt;  /* ...of which from swap. */
+
+/* Initializes the running thread's supplemental page table.
+   Returns true if successful, false if memory allocation
+   failed. */
+bool
+page_table_init (void)
+{
+  return hash_init (&thread_current ()->pages, page_hash, page_less, NULL);
+}
+
+/* Frees every page in the running thread's supplemental page
+   table, along with the frames that hold them, and removes them
+   from its page directory. */
+void
+page_table_destroy (void)
+{
+  hash_destroy (&thread_current ()->pages, page_destroy);
+}
+
+/* Adds a page at UPAGE to the running thread's supplemental page
+   table, to be filled with READ_BYTES bytes read from FILE at
+   offset OFS followed by zeros, and returns it.  Returns a null
+   pointer if UPAGE is already in use or memory allocation
+   failed. */
+static struct page *
+add_page (void *upage, struct file *file, off_t ofs, size_t read_bytes,
+          bool writable)
+{
+  struct thread *t = thread_current ();
+  struct page *p;
+
+  ASSERT (pg_ofs (upage) == 0);
+  ASSERT (read_bytes <= PGSIZE);
+
+  p = malloc (sizeof *p);
+  if (p == NULL)
+    return NULL;
+  p->upage = upage;
+  p->thread = t;
+  p->writable = writable;
+  p->frame = NULL;
+  p->evicting = false;
+  p->dirty = false;
+  p->swap_slot = SWAP_ERROR;
+  p->file = read_bytes > 0 ? file : NULL;
+  p->file_ofs = ofs;
+  p->read_bytes = read_bytes;
+  p->write_back = false;
+  p->shareable = false;
+  p->shared = NULL;
+
+  if (hash_insert (&t->pages, &p->hash_elem) != NULL)
+    {
+      free (p);
+      return NULL;
+    }
+  return p;
+}
+
+/* Adds a page at UPAGE to the running thread's supplemental page
+   table, to be filled with READ_BYTES bytes read from FILE at
+   offset OFS followed by zeros.  The page is read-only unless
+   WRITABLE is true.  A read-only page with bytes from FILE is
+   shared with every other process that has the same bytes of
+   FILE mapped; FILE must then not change while it is mapped.
+   Returns true if successful, false if UPAGE is already in use
+   or memory allocation failed. */
+bool
+page_add_file (void *upage, struct file *file, off_t ofs,
+               size_t read_bytes, bool writable)
+{
+  struct page *p = add_page (upage, file, ofs, read_bytes, writable);
+
+  if (p == NULL)
+    return false;
+  p->shareable = !writable && p->file != NULL;
+  return true;
+}
+
+/* Adds a writable page at UPAGE to the running thread's
+   supplemental page table that maps READ_BYTES bytes of FILE at
+   offset OFS, which must be more than 0.  Changes to those bytes
+   are written back to FILE when the page is evicted or removed
+   with page_unmap().  Returns true if successful, false if UPAGE
+   is already in use or memory allocation failed. */
+bool
+page_add_mmap (void *upage, struct file *file, off_t ofs, size_t read_bytes)
+{
+  struct page *p;
+
+  ASSERT (read_bytes > 0);
+
+  p = add_page (upage, file, ofs, read_bytes, true);
+  if (p == NULL)
+    return false;
+  p->write_back = true;
+  return true;
+}
+
+/* Adds a page at UPAGE, to be filled with zeros, to the running
+   thread's supplemental page table.  The page is read-only
+   unless WRITABLE is true.  Returns true if successful, false
+   if UPAGE is already in use or memory allocation failed. */
+bool
+page_add_zero (void *upage, bool writable)
+{
+  return page_add_file (upage, NULL, 0, 0, writable);
+}
+
+/* Returns the page containing ADDR in the running thread's
+   supplemental page table, or a null pointer if there is none. */
+struct page *
+page_lookup (const void *addr)
+{
+  struct page p;
+  struct hash_elem *e;
+
+  p.upage = pg_round_down (addr);
+  e = hash_find (&thread_current ()->pages, &p.hash_elem);
+  return e != NULL ? hash_entry (e, struct page, hash_elem) : NULL;
+}
+
+/* Makes the page containing ADDR in the running thread's address
+   space resident, if it is not already, by giving it a frame,
+   filling that in from swap or from the page's file, and mapping
+   it.  Returns true if successful, false if ADDR is not in any
+   page or the page could not be brought in. */
+bool
+page_in (const void *addr)
+{
+  struct thread *t = thread_current ();
+  struct page *p;
+  struct frame *f;
+  enum intr_level old_level;
+  uint64_t start;
+  bool from_swap;
+
+  /* Kernel threads have no user pages. */
+  if (t->pagedir == NULL)
+    return false;
+
+  p = page_lookup (addr);
+  if (p == NULL)
+    return false;
+  if (p->shareable)
+    return p->shared != NULL || share_page_in (p);
+  if (frame_wait (p))
+    return true;
+
+  start = rdtsc ();
+  from_swap = p->swap_slot != SWAP_ERROR;
+  f = frame_alloc (p, !from_swap && p->read_bytes == 0);
+  if (f == NULL)
+    return false;
+
+  if (from_swap)
+    {
+      swap_read (p->swap_slot, f->kpage);
+      swap_free (p->swap_slot);
+      p->swap_slot = SWAP_ERROR;
+    }
+  else if (p->read_bytes > 0)
+    {
+      off_t read = file_read_at (p->file, f->kpage, p->read_bytes,
+                                 p->file_ofs);
+      if (read != (off_t) p->read_bytes)
+        {
+          frame_free (f);
+          return false;
+        }
+      memset ((uint8_t *) f->kpage + p->read_bytes, 0,
+              PGSIZE - p->read_bytes);
+    }
+
+  if (!pagedir_set_page (t->pagedir, p->upage, f->kpage, p->writable))
+    {
+      frame_free (f);
+      return false;
+    }
+  frame_install (f);
+
+  old_level = intr_disable ();
+  fault_cnt++;
+  fault_cycles += rdtsc () - start;
+  if (from_swap)
+    swap_in_cnt++;
+  intr_set_level (old_level);
+  return true;
+}
+
+/* Grows the running thread's stack to cover ADDR, if ADDR looks
+   like a stack access by a process whose stack pointer is ESP:
+   at most 32 bytes below ESP, as PUSHA may write, and less than
+   page_stack_max bytes below PHYS_BASE.  The new page is zeroed
+   and brought in at once.  Returns true if successful, false if
+   ADDR is not a stack access or memory is short. */
+bool
+page_grow_stack (const void *addr, const void *esp)
+{
+  void *upage = pg_round_down (addr);
+
+  if ((uintptr_t) addr + 32 < (uintptr_t) esp
+      || !is_user_vaddr (addr)
+      || (uintptr_t) PHYS_BASE - (uintptr_t) upage > page_stack_max)
+    return false;
+
+  if (!page_add_zero (upage, true))
+    return false;
+  return page_in (upage);
+}
+
+/* Writes back to its file page P, which must have been added
+   with page_add_mmap(), if it was modified, then removes it from
+   the running thread's supplemental page table and frees it. */
+void
+page_unmap (struct page *p)
+{
+  struct frame *f;
+
+  ASSERT (p->write_back);
+
+  /* Changes that were swapped out have to be brought back in
+     before they can be written to the file. */
+  while ((f = frame_pin (p)) == NULL && p->swap_slot != SWAP_ERROR)
+    if (!page_in (p->upage))
+      break;
+
+  if (f != NULL)
+    {
+      if (p->dirty || pagedir_is_dirty (p->thread->pagedir, p->upage))
+        page_write_back (p, f->kpage);
+      frame_unpin (f);
+    }
+
+  hash_delete (&p->thread->pages, &p->hash_elem);
+  page_destroy (&p->hash_elem, NULL);
+}
+
+/* Writes the part of page P, which must have been added with
+   page_add_mmap(), that is backed by its file from KPAGE to the
+   file. */
+void
+page_write_back (struct page *p, const void *kpage)
+{
+  ASSERT (p->write_back);
+
+  file_write_at (p->file, kpage, p->read_bytes, p->file_ofs);
+}
+
+/* Prints page fault statistics. */
+void
+page_print_stats (void)
+{
+  printf ("Page: %llu pages faulted in (%llu from swap), "
+          "%llu cycles each on average\n",
+          fault_cnt, swap_in_cnt,
+          fault_cnt > 0 ? fault_cycles / fault_cnt : 0);
+}
+
+/* Returns a hash value for the page that E refers to. */
+static unsigned
+page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct page *p = hash_entry (e, struct page, hash_elem);
+  return hash_bytes (&p->upage, sizeof p->upage);
+}
+
+/* Returns true if page A precedes page B. */
+static bool
+page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+           void *aux UNUSED)
+{
+  const struct page *a = hash_entry (a_, struct page, hash_elem);
+  const struct page *b = hash_entry (b_, struct page, hash_elem);
+
+  return a->upage < b->upage;
+}
+
+/* Frees the page that E refers to, and its frame or swap slot
+   if it has one.  For hash_destroy(). */
+static void
+page_destroy (struct hash_elem *e, void *aux UNUSED)
+{
+  struct page *p = hash_entry (e, struct page, hash_elem);
+
+  if (p->shared != NULL)
+    share_release (p);
+  frame_release_page (p);
+  if (p->swap_slot != SWAP_ERROR)
+    swap_free (p->swap_slot);
+  free (p);
+}
@@ -0,0 +1,71 @@
+#ifndef VM_PAGE_H
+#define VM_PAGE_H
+
+#include <hash.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+#include "vm/swap.h"
+
+struct file;
+struct shared_frame;
+struct thread;
+
+/* A page of a process's virtual address space, as recorded in
+   its supplemental page table.
+
+   A page is created without a frame and gets one, filled with its
+   initial contents, the first time it is touched.  Those contents
+   are READ_BYTES bytes read from FILE at FILE_OFS followed by
+   zeros, or just zeros if FILE is null.
+
+   A page that is evicted while DIRTY goes to swap, and DIRTY
+   stays set from then on, because its contents no longer match
+   FILE; a clean page is simply read in again.  A WRITE_BACK
+   page, which maps part of a file, instead goes back to FILE,
+   after which it is clean.
+
+   A SHAREABLE page, which is a read-only page of FILE, is never
+   given a frame of its own.  It maps the frame that vm/share.c
+   keeps for those bytes of FILE, shared with every other process
+   that maps them, and SHARED points to that once it is mapped.  See vm/frame.c
+   for the locking of FRAME and EVICTING. */
+struct page
+  {
+    void *upage;                /* User virtual address. */
+    struct thread *thread;      /* Owning thread. */
+    bool writable;              /* Read/write or read-only? */
+    struct frame *frame;        /* Frame holding the page, or null. */
+    bool evicting;              /* Being evicted from FRAME? */
+    bool dirty;                 /* Modified since first read in? */
+    swap_slot_t swap_slot;      /* Slot holding the page, or SWAP_ERROR. */
+
+    struct file *file;          /* File to read from, or null. */
+    off_t file_ofs;             /* Offset in FILE. */
+    size_t read_bytes;          /* Bytes to read from FILE. */
+    bool write_back;            /* Write changes back to FILE? */
+    bool shareable;             /* Map a shared frame? */
+    struct shared_frame *shared; /* Shared frame mapped, or null. */
+
+    struct hash_elem hash_elem; /* Element in supplemental page table. */
+  };
+
+extern size_t page_stack_max;
+
+bool page_table_init (void);
+void page_table_destroy (void);
+
+bool page_add_file (void *upage, struct file *, off_t ofs,
+                    size_t read_bytes, bool writable);
+bool page_add_zero (void *upage, bool writable);
+bool page_add_mmap (void *upage, struct file *, off_t ofs,
+                    size_t read_bytes);
+struct page *page_lookup (const void *addr);
+bool page_in (const void *addr);
+bool page_grow_stack (const void *addr, const void *esp);
+void page_unmap (struct page *);
+void page_write_back (struct page *, const void *kpage);
+
+void page_print_stats (void);
+
+#endif /* vm/page.h */
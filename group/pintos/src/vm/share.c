@@ -0,0 +1,231 @@
+#include "vm/share.h"
+#include <debug.h>
+#include <hash.h>
+#include <stdio.h>
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "vm/frame.h"
+#include "vm/page.h"
+
+/* A frame holding a read-only page of a file, mapped by every
+   process that has a shareable page (see page_add_file()) for
+   the same bytes of the same file.
+
+   The frame stays pinned, and so is never evicted, until the
+   last process that maps it releases it.  Only read-only
+   executable pages are shared, and a running executable cannot
+   be written, so the frame cannot go stale. */
+struct shared_frame
+  {
+    struct inode *inode;        /* File's inode. */
+    off_t ofs;                  /* Offset in file. */
+    size_t read_bytes;          /* Bytes read from the file. */
+    struct frame *frame;        /* Frame holding the bytes. */
+    unsigned map_cnt;           /* Number of pages mapping it. */
+    struct hash_elem elem;      /* Element in shared_frames. */
+  };
+
+/* All shared frames, keyed by inode and offset. */
+static struct hash shared_frames;
+static struct lock share_lock;
+
+/* Statistics, updated under share_lock. */
+static unsigned long long map_cnt;      /* Pages mapped. */
+static unsigned long long hit_cnt;      /* ...whose frame was in memory. */
+static size_t frame_cnt;                /* Shared frames now. */
+static size_t peak_frame_cnt;           /* Most there ever were. */
+
+static struct shared_frame *lookup (const struct shared_frame *);
+static struct shared_frame *read_page (struct page *,
+                                       const struct shared_frame *);
+static void discard (struct shared_frame *);
+static hash_hash_func shared_frame_hash;
+static hash_less_func shared_frame_less;
+
+/* Initializes the table of shared frames. */
+void
+share_init (void)
+{
+  hash_init (&shared_frames, shared_frame_hash, shared_frame_less, NULL);
+  lock_init (&share_lock);
+}
+
+/* Maps shareable page P into its owner's page directory, using
+   the shared frame that holds its bytes if there is one and
+   reading them into a new shared frame otherwise.  P must not be
+   mapped already.  Returns true if successful, false if memory
+   allocation or reading the file failed. */
+bool
+share_page_in (struct page *p)
+{
+  struct shared_frame key, *sf;
+  bool success = false;
+
+  ASSERT (p->shared == NULL);
+
+  key.inode = file_get_inode (p->file);
+  key.ofs = p->file_ofs;
+  key.read_bytes = p->read_bytes;
+
+  lock_acquire (&share_lock);
+  sf = lookup (&key);
+  if (sf != NULL)
+    hit_cnt++;
+  else
+    {
+      /* Read the page without holding share_lock, so that faults
+         on other shared pages need not wait for the disk, then
+         check that nobody beat us to it. */
+      struct shared_frame *new;
+
+      lock_release (&share_lock);
+      new = read_page (p, &key);
+      if (new == NULL)
+        return false;
+      lock_acquire (&share_lock);
+
+      sf = lookup (&key);
+      if (sf != NULL)
+        discard (new);
+      else
+        {
+          sf = new;
+          hash_insert (&shared_frames, &sf->elem);
+          if (++frame_cnt > peak_frame_cnt)
+            peak_frame_cnt = frame_cnt;
+        }
+    }
+
+  if (pagedir_set_page (p->thread->pagedir, p->upage, sf->frame->kpage,
+                        false))
+    {
+      sf->map_cnt++;
+      p->shared = sf;
+      process_count_resident (p->thread, 1);
+      map_cnt++;
+      success = true;
+    }
+  else if (sf->map_cnt == 0)
+    {
+      hash_delete (&shared_frames, &sf->elem);
+      discard (sf);
+      frame_cnt--;
+    }
+  lock_release (&share_lock);
+
+  return success;
+}
+
+/* Unmaps page P, which must have been mapped by share_page_in(),
+   and frees its shared frame if no other page maps it. */
+void
+share_release (struct page *p)
+{
+  struct shared_frame *sf = p->shared;
+
+  ASSERT (sf != NULL);
+
+  lock_acquire (&share_lock);
+  pagedir_clear_page (p->thread->pagedir, p->upage);
+  p->shared = NULL;
+  if (--sf->map_cnt == 0)
+    {
+      hash_delete (&shared_frames, &sf->elem);
+      discard (sf);
+      frame_cnt--;
+    }
+  lock_release (&share_lock);
+}
+
+/* Prints statistics about shared frames. */
+void
+share_print_stats (void)
+{
+  printf ("Share: %llu read-only pages mapped, %llu of them already in "
+          "memory, %zu shared frames at peak\n",
+          map_cnt, hit_cnt, peak_frame_cnt);
+}
+
+/* Returns the shared frame with the same inode, offset, and
+   length as KEY, or a null pointer if there is none.  share_lock
+   must be held. */
+static struct shared_frame *
+lookup (const struct shared_frame *key)
+{
+  struct hash_elem *e = hash_find (&shared_frames,
+                                   (struct hash_elem *) &key->elem);
+  return e != NULL ? hash_entry (e, struct shared_frame, elem) : NULL;
+}
+
+/* Returns a new shared frame, not yet in shared_frames, with the
+   key in KEY, holding the bytes of page P.  Returns a null
+   pointer if memory allocation or reading the file failed. */
+static struct shared_frame *
+read_page (struct page *p, const struct shared_frame *key)
+{
+  struct shared_frame *sf;
+  off_t read;
+
+  sf = malloc (sizeof *sf);
+  if (sf == NULL)
+    return NULL;
+  *sf = *key;
+  sf->map_cnt = 0;
+  sf->frame = frame_alloc (NULL, false);
+  if (sf->frame == NULL)
+    {
+      free (sf);
+      return NULL;
+    }
+
+  read = file_read_at (p->file, sf->frame->kpage, p->read_bytes,
+                       p->file_ofs);
+  if (read != (off_t) p->read_bytes)
+    {
+      discard (sf);
+      return NULL;
+    }
+  memset ((uint8_t *) sf->frame->kpage + p->read_bytes, 0,
+          PGSIZE - p->read_bytes);
+  return sf;
+}
+
+/* Frees shared frame SF, which no page may map. */
+static void
+discard (struct shared_frame *sf)
+{
+  ASSERT (sf->map_cnt == 0);
+
+  frame_free (sf->frame);
+  free (sf);
+}
+
+/* Returns a hash value for the shared frame that E refers to. */
+static unsigned
+shared_frame_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct shared_frame *sf = hash_entry (e, struct shared_frame, elem);
+  return hash_bytes (&sf->inode, sizeof sf->inode) ^ hash_int (sf->ofs);
+}
+
+/* Returns true if shared frame A precedes shared frame B. */
+static bool
+shared_frame_less (const struct hash_elem *a_, const struct hash_elem *b_,
+                   void *aux UNUSED)
+{
+  const struct shared_frame *a = hash_entry (a_, struct shared_frame, elem);
+  const struct shared_frame *b = hash_entry (b_, struct shared_frame, elem);
+
+  if (a->inode != b->inode)
+    return a->inode < b->inode;
+  else if (a->ofs != b->ofs)
+    return a->ofs < b->ofs;
+  else
+    return a->read_bytes < b->read_bytes;
+}
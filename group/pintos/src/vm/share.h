@@ -0,0 +1,13 @@
+#ifndef VM_SHARE_H
+#define VM_SHARE_H
+
+#include <stdbool.h>
+
+struct page;
+
+void share_init (void);
+bool share_page_in (struct page *);
+void share_release (struct page *);
+void share_print_stats (void);
+
+#endif /* vm/share.h */
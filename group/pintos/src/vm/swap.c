@@ -0,0 +1,119 @@
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <stdio.h>
+#include "devices/block.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Number of sectors in a swap slot. */
+#define SECTORS_PER_SLOT (PGSIZE / BLOCK_SECTOR_SIZE)
+
+/* Swap device, or null if there is none. */
+static struct block *swap_device;
+
+/* Slots in use.  Has a summary, so that finding a free slot does
+   not have to walk the whole map when swap is nearly full. */
+static struct bitmap *swap_map;
+static struct lock swap_lock;
+
+/* Statistics.  The counts of slots written and read are
+   updated with interrupts off, the others under swap_lock. */
+static unsigned long long write_cnt;    /* Slots written. */
+static unsigned long long read_cnt;     /* Slots read. */
+static size_t used_cnt;                 /* Slots in use now. */
+static size_t peak_used;                /* Most slots ever in use. */
+
+/* Sets up swapping to the block device with the BLOCK_SWAP role,
+   if there is one.  Without one, swap_alloc() always fails. */
+void
+swap_init (void)
+{
+  lock_init (&swap_lock);
+  swap_device = block_get_role (BLOCK_SWAP);
+  if (swap_device == NULL)
+    return;
+
+  swap_map = bitmap_create_with_summary (block_size (swap_device)
+                                         / SECTORS_PER_SLOT);
+  if (swap_map == NULL)
+    PANIC ("swap map creation failed--swap device is too large");
+}
+
+/* Allocates CNT contiguous swap slots and returns the first, or
+   SWAP_ERROR if there is no run of CNT free slots. */
+swap_slot_t
+swap_alloc (size_t cnt)
+{
+  swap_slot_t slot;
+
+  if (swap_map == NULL)
+    return SWAP_ERROR;
+
+  lock_acquire (&swap_lock);
+  slot = bitmap_scan_and_flip (swap_map, 0, cnt, false);
+  if (slot != BITMAP_ERROR)
+    {
+      used_cnt += cnt;
+      if (used_cnt > peak_used)
+        peak_used = used_cnt;
+    }
+  lock_release (&swap_lock);
+
+  return slot != BITMAP_ERROR ? slot : SWAP_ERROR;
+}
+
+/* Releases swap slot SLOT. */
+void
+swap_free (swap_slot_t slot)
+{
+  lock_acquire (&swap_lock);
+  ASSERT (bitmap_test (swap_map, slot));
+  bitmap_reset (swap_map, slot);
+  used_cnt--;
+  lock_release (&swap_lock);
+}
+
+/* Writes the page at KPAGE to swap slot SLOT. */
+void
+swap_write (swap_slot_t slot, const void *kpage)
+{
+  block_sector_t sector = slot * SECTORS_PER_SLOT;
+  enum intr_level old_level;
+  size_t i;
+
+  for (i = 0; i < SECTORS_PER_SLOT; i++)
+    block_write (swap_device, sector + i,
+                 (const uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+  old_level = intr_disable ();
+  write_cnt++;
+  intr_set_level (old_level);
+}
+
+/* Reads swap slot SLOT into the page at KPAGE. */
+void
+swap_read (swap_slot_t slot, void *kpage)
+{
+  block_sector_t sector = slot * SECTORS_PER_SLOT;
+  enum intr_level old_level;
+  size_t i;
+
+  for (i = 0; i < SECTORS_PER_SLOT; i++)
+    block_read (swap_device, sector + i,
+                (uint8_t *) kpage + i * BLOCK_SECTOR_SIZE);
+  old_level = intr_disable ();
+  read_cnt++;
+  intr_set_level (old_level);
+}
+
+/* Prints swap statistics. */
+void
+swap_print_stats (void)
+{
+  if (swap_device == NULL)
+    return;
+  printf ("Swap: %llu pages written, %llu read, %zu of %zu slots "
+          "in use at peak\n",
+          write_cnt, read_cnt, peak_used, bitmap_size (swap_map));
+}
@@ -0,0 +1,18 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Index of a page-sized slot on the swap device. */
+typedef size_t swap_slot_t;
+#define SWAP_ERROR SIZE_MAX
+
+void swap_init (void);
+swap_slot_t swap_alloc (size_t cnt);
+void swap_free (swap_slot_t);
+void swap_write (swap_slot_t, const void *kpage);
+void swap_read (swap_slot_t, void *kpage);
+void swap_print_stats (void);
+
+#endif /* vm/swap.h */